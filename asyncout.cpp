@@ -0,0 +1,141 @@
+#pragma once
+
+#include <ostream>
+#include <streambuf>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#define ASYNC_SLOTS 8 // buffers in the ring between simulation and writer
+#define ASYNC_BUFFER 262144 // bytes per buffer
+
+using namespace std;
+
+/*
+ * AsyncStreamBuf - stream buffer that writes to another stream on its own
+ *                  thread.
+ *
+ * Text goes into one of ASYNC_SLOTS preallocated buffers. A full buffer is
+ * handed to the writer thread through a lock-free single-producer/single-
+ * consumer ring and the next free one is taken, so the simulation only
+ * waits for the disk when every buffer is full. Flushes (e.g. endl) do not
+ * reach the file; Drain() and Close() write out whatever is left.
+ */
+class AsyncStreamBuf : public streambuf
+{
+public:
+    AsyncStreamBuf(ostream &out) : _out(out), _slots(ASYNC_SLOTS), _sizes(ASYNC_SLOTS, 0)
+    {
+        for (int k = 0; k < ASYNC_SLOTS; k++)
+        {
+            _slots[k].resize(ASYNC_BUFFER);
+        }
+        _head = 0;
+        _tail = 0;
+        _published = 0;
+        _closing = false;
+        _closed = false;
+        setp(&_slots[0][0], &_slots[0][0] + ASYNC_BUFFER);
+        _writer = thread(&AsyncStreamBuf::Write, this);
+    }
+    ~AsyncStreamBuf()
+    {
+        Close();
+    }
+    void Drain() // wait until everything so far is in the file
+    {
+        if (_closed)
+        {
+            return;
+        }
+        Publish();
+        while (_tail.load(memory_order_acquire) != _head.load(memory_order_relaxed))
+        {
+            this_thread::yield();
+        }
+        _out.flush();
+    }
+    void Close() // hand over the last buffer and wait until everything is written
+    {
+        if (_closed)
+        {
+            return;
+        }
+        Publish();
+        _closing.store(true, memory_order_release);
+        _writer.join();
+        _out.flush();
+        _closed = true;
+    }
+protected:
+    int overflow(int c) // current buffer is full
+    {
+        Publish();
+        if (c != EOF)
+        {
+            *pptr() = (char)c;
+            pbump(1);
+        }
+        return (c == EOF) ? 0 : c;
+    }
+    int sync() // flushing is left to the writer thread
+    {
+        return 0;
+    }
+    streampos seekoff(streamoff off, ios_base::seekdir dir, ios_base::openmode which) // only tellp(): bytes written so far
+    {
+        if (off != 0 || dir != ios_base::cur || which != ios_base::out)
+        {
+            return streampos(-1);
+        }
+        return streampos(_published + (pptr() - pbase()));
+    }
+private:
+    void Publish() // hand the current buffer to the writer, start on the next one
+    {
+        unsigned head = _head.load(memory_order_relaxed);
+        _sizes[head % ASYNC_SLOTS] = pptr() - pbase();
+        _published += pptr() - pbase();
+        _head.store(head + 1, memory_order_release);
+        head++;
+        // Wait only if the writer has not yet emptied the next buffer
+        while (head - _tail.load(memory_order_acquire) >= ASYNC_SLOTS)
+        {
+            this_thread::yield();
+        }
+        char *next = &_slots[head % ASYNC_SLOTS][0];
+        setp(next, next + ASYNC_BUFFER);
+    }
+    void Write() // writer thread: write out buffers in order until closed
+    {
+        while (true)
+        {
+            unsigned tail = _tail.load(memory_order_relaxed);
+            if (tail == _head.load(memory_order_acquire))
+            {
+                if (_closing.load(memory_order_acquire) && tail == _head.load(memory_order_acquire))
+                {
+                    return;
+                }
+                this_thread::sleep_for(chrono::microseconds(100));
+                continue;
+            }
+            int k = tail % ASYNC_SLOTS;
+            if (_sizes[k] > 0)
+            {
+                _out.write(&_slots[k][0], _sizes[k]);
+            }
+            _tail.store(tail + 1, memory_order_release);
+        }
+    }
+    ostream &_out;
+    vector<vector<char> > _slots; // the ring of buffers
+    vector<long> _sizes; // bytes used in each published buffer
+    long long _published; // bytes handed to the writer so far
+    atomic<unsigned> _head; // buffers published by the simulation
+    atomic<unsigned> _tail; // buffers written out by the writer thread
+    atomic<bool> _closing;
+    bool _closed;
+    thread _writer;
+};
@@ -0,0 +1,490 @@
+/*
+ * bench - times the scheduler on synthetic kitchens
+ *
+ * Usage: bench [--dishes N,...] [--burst N,...] [--cook F,...]
+ *              [--steps N,...] [--load X] [--stoves N] [--ticks N]
+ *              [--event] [--seed N] [--dir PATH] [--out FILE]
+ *
+ * Every combination of the lists is one case. For each case a tasklist and
+ * recipes are generated in the work directory (default bench-work), then
+ *   parse    - reading the recipes and the tasklist is timed;
+ *   proceed  - the simulation is run without output, one Proceed() (and
+ *              Retire()) per "second", up to --ticks "seconds";
+ *   schedule - Schedule() is timed on copies of the kitchen taken at
+ *              "seconds" 16, 32, 64, ... of that run;
+ *   output   - the same run is repeated writing output.csv, and the extra
+ *              time is put down to formatting and writing rows; the heap
+ *              allocations of this run are counted, in all and over its
+ *              second half (when the kitchen is in full swing).
+ * Results go to FILE (default bench.json) in the Google Benchmark JSON
+ * layout, one entry per case, and a summary to stdout.
+ */
+
+#define SCHEDULER_NO_MAIN
+#include <random>
+#include <filesystem>
+#include "scheduler.cpp"
+
+#define BENCH_RECIPES 8 // recipes per generated kitchen
+#define BENCH_SAMPLE 16 // first "second" at which Schedule() is timed (then 32, 64, ...)
+#define BENCH_CALLS 64 // Schedule() calls per stove and point
+
+using namespace std;
+
+typedef chrono::steady_clock bench_clock;
+
+// Heap allocations by the thread running a simulation, while counting
+thread_local bool bench_counting = false;
+thread_local long long bench_allocs = 0;
+
+/* bench_alloc() - allocates for every form of operator new below, and
+ *                 counts the allocation
+ *               - arguments are size, alignment & whether to return NULL
+ *                 rather than throw if out of memory
+ */
+__attribute__((noinline)) void *bench_alloc(size_t size, size_t align, bool nothrow)
+{
+    if (bench_counting)
+    {
+        bench_allocs++;
+    }
+    void *p = NULL;
+    if (align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    {
+        p = malloc(size ? size : 1);
+    }
+    else if (posix_memalign(&p, align, size ? size : 1) != 0)
+    {
+        p = NULL;
+    }
+    if (p == NULL && !nothrow)
+    {
+        throw bad_alloc();
+    }
+    return p;
+}
+/* bench_free() - frees for every form of operator delete below (kept out
+ *                of line, so that the compiler does not pair the free()
+ *                with the operator new at the call site)
+ */
+__attribute__((noinline)) void bench_free(void *p)
+{
+    free(p);
+}
+
+// The whole family of replaceable operators, so that every allocation is
+//  counted and freed the same way
+void *operator new(size_t size) { return bench_alloc(size, 0, false); }
+void *operator new[](size_t size) { return bench_alloc(size, 0, false); }
+void *operator new(size_t size, const nothrow_t &) noexcept { return bench_alloc(size, 0, true); }
+void *operator new[](size_t size, const nothrow_t &) noexcept { return bench_alloc(size, 0, true); }
+void *operator new(size_t size, align_val_t a) { return bench_alloc(size, (size_t)a, false); }
+void *operator new[](size_t size, align_val_t a) { return bench_alloc(size, (size_t)a, false); }
+void *operator new(size_t size, align_val_t a, const nothrow_t &) noexcept { return bench_alloc(size, (size_t)a, true); }
+void *operator new[](size_t size, align_val_t a, const nothrow_t &) noexcept { return bench_alloc(size, (size_t)a, true); }
+void operator delete(void *p) noexcept { bench_free(p); }
+void operator delete[](void *p) noexcept { bench_free(p); }
+void operator delete(void *p, size_t) noexcept { bench_free(p); }
+void operator delete[](void *p, size_t) noexcept { bench_free(p); }
+void operator delete(void *p, const nothrow_t &) noexcept { bench_free(p); }
+void operator delete[](void *p, const nothrow_t &) noexcept { bench_free(p); }
+void operator delete(void *p, align_val_t) noexcept { bench_free(p); }
+void operator delete[](void *p, align_val_t) noexcept { bench_free(p); }
+void operator delete(void *p, size_t, align_val_t) noexcept { bench_free(p); }
+void operator delete[](void *p, size_t, align_val_t) noexcept { bench_free(p); }
+void operator delete(void *p, align_val_t, const nothrow_t &) noexcept { bench_free(p); }
+void operator delete[](void *p, align_val_t, const nothrow_t &) noexcept { bench_free(p); }
+
+double seconds_since(bench_clock::time_point start)
+{
+    return chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+/*
+ * Workload - a synthetic kitchen: recipes and a tasklist
+ */
+class Workload
+{
+public:
+    Workload(int dishes, int burst, double cook, int steps)
+    {
+        _dishes = dishes; // number of orders in the tasklist
+        _burst = burst; // orders that come in at the same "second"
+        _cook = cook; // share of recipe steps that are COOK (the rest PREP)
+        _steps = steps; // steps per recipe
+    }
+    string GetName() // e.g. "dishes=1000/burst=10/cook=0.5/steps=3"
+    {
+        ostringstream name;
+        name << "dishes=" << _dishes << "/burst=" << _burst << "/cook=" << _cook << "/steps=" << _steps;
+        return name.str();
+    }
+    int GetDishes() // getter for number of orders
+    {
+        return _dishes;
+    }
+    int GetBurst() // getter for orders per burst
+    {
+        return _burst;
+    }
+    double GetCook() // getter for share of COOK steps
+    {
+        return _cook;
+    }
+    int GetSteps() // getter for steps per recipe
+    {
+        return _steps;
+    }
+    // Write recipes/ and tasklist.txt to the current directory. Orders
+    //  come in bursts spaced so that the stoves get 'load' times as much
+    //  cooking as they can do.
+    void Write(double load, int stoves, unsigned seed)
+    {
+        mt19937 rng(seed);
+        uniform_int_distribution<int> time(1, 30);
+        uniform_int_distribution<int> priority(1, QUEUE_COUNT);
+        bernoulli_distribution isCook(_cook);
+
+        filesystem::create_directories(RECIPEDIR);
+        long cooking = 0; // COOK "seconds" of all recipes together
+        for (int r = 0; r < BENCH_RECIPES; r++)
+        {
+            ofstream recipe((RECIPEDIR + Dish(r) + ".txt").c_str());
+            recipe << Dish(r) << " " << priority(rng) << endl;
+            for (int k = 0; k < _steps; k++)
+            {
+                int t = time(rng);
+                bool c = isCook(rng);
+                cooking += c ? t : 0;
+                recipe << (c ? "cook " : "prep ") << t << endl;
+            }
+        }
+
+        // Mean "seconds" between bursts for the wanted load
+        double gap = (double)cooking / BENCH_RECIPES * _burst / stoves / load;
+        exponential_distribution<double> between(1 / max(gap, 1e-9));
+        uniform_int_distribution<int> dish(0, BENCH_RECIPES - 1);
+        ofstream tasklist(INPUTFILE);
+        double at = 1;
+        for (int i = 0; i < _dishes; i++)
+        {
+            if (i > 0 && i % _burst == 0)
+            {
+                at += between(rng);
+            }
+            tasklist << Dish(dish(rng)) << " " << (long)at << "\n";
+        }
+    }
+private:
+    string Dish(int r) // name of generated recipe r
+    {
+        return "dish" + to_string(r);
+    }
+    int _dishes;
+    int _burst;
+    double _cook;
+    int _steps;
+};
+
+/*
+ * Bench - the timed phases of one case
+ */
+class Bench
+{
+public:
+    Bench(Scheduler &proto, int ticks)
+    {
+        _proto = proto; // settings every run starts from
+        _ticks = ticks; // most "seconds" simulated per run
+        _steady = 0;
+    }
+    // Time one case and write it as a JSON object to json
+    void Run(Workload &w, ostream &json)
+    {
+        // Parse
+        Scheduler core = _proto;
+        RecipeBook book;
+        bench_clock::time_point start = bench_clock::now();
+        book.LoadAll();
+        load_tasklist(INPUTFILE, book, core.GetOrders());
+        double parse = seconds_since(start);
+
+        // Proceed, with Schedule() timed on the side
+        Scheduler run = core;
+        double schedule = 0;
+        long calls = 0;
+        long done = 0;
+        double proceed = Simulate(run, NULL, done, &schedule, &calls, NULL);
+        int ticks = run._time;
+
+        // Output, counting allocations in all and from halfway on
+        run = core;
+        long written = 0;
+        long long allocs[2] = {0, 0};
+        _steady = ticks / 2;
+        double output = Simulate(run, &written, done, NULL, NULL, allocs);
+        double perTick = (double)allocs[0] / max(ticks, 1);
+        double steadyPerTick = (double)allocs[1] / max(ticks - _steady, 1);
+
+        cout << left << setw(46) << w.GetName()
+             << fixed << setprecision(0) << setw(14) << ticks / proceed << " ticks/s  "
+             << setw(12) << done / proceed << " dishes/s  "
+             << setprecision(1) << setw(8) << schedule / max(calls, 1L) * 1e9 << " ns/Schedule()  "
+             << setprecision(3) << steadyPerTick << " allocs/tick" << endl;
+        cout.unsetf(ios::floatfield);
+
+        json << "    {" << endl;
+        json << "      \"name\": \"" << w.GetName() << "\"," << endl;
+        json << "      \"run_type\": \"iteration\"," << endl;
+        json << "      \"iterations\": " << ticks << "," << endl;
+        json << "      \"real_time\": " << proceed / max(ticks, 1) * 1e9 << "," << endl;
+        json << "      \"time_unit\": \"ns\"," << endl;
+        json << "      \"dishes\": " << w.GetDishes() << "," << endl;
+        json << "      \"burst\": " << w.GetBurst() << "," << endl;
+        json << "      \"cook_share\": " << w.GetCook() << "," << endl;
+        json << "      \"steps\": " << w.GetSteps() << "," << endl;
+        json << "      \"ticks\": " << ticks << "," << endl;
+        json << "      \"dishes_done\": " << done << "," << endl;
+        json << "      \"parse_seconds\": " << parse << "," << endl;
+        json << "      \"parse_dishes_per_second\": " << w.GetDishes() / parse << "," << endl;
+        json << "      \"proceed_seconds\": " << proceed << "," << endl;
+        json << "      \"ticks_per_second\": " << ticks / proceed << "," << endl;
+        json << "      \"dishes_per_second\": " << done / proceed << "," << endl;
+        json << "      \"schedule_calls\": " << calls << "," << endl;
+        json << "      \"schedule_ns\": " << schedule / max(calls, 1L) * 1e9 << "," << endl;
+        json << "      \"output_seconds\": " << max(output - proceed, 0.0) << "," << endl;
+        json << "      \"output_bytes\": " << written << "," << endl;
+        json << "      \"output_ticks_per_second\": " << ticks / output << "," << endl;
+        json << "      \"allocations\": " << allocs[0] << "," << endl;
+        json << "      \"allocations_per_tick\": " << perTick << "," << endl;
+        json << "      \"steady_allocations_per_tick\": " << steadyPerTick << endl;
+        json << "    }";
+    }
+private:
+    // Run the simulation up to _ticks "seconds", writing rows to output.csv
+    //  if written is given (set to its size). Sets done to the number of
+    //  dishes done. Schedule() is timed if schedule and calls are given.
+    //  Heap allocations are counted if allocs is given: allocs[0] in all,
+    //  allocs[1] from "second" _steady on. Returns the time taken by the
+    //  simulation itself.
+    double Simulate(Scheduler &core, long *written, long &done, double *schedule, long *calls, long long *allocs)
+    {
+        ofstream out;
+        AsyncStreamBuf *async = NULL;
+        if (written)
+        {
+            out.open(OUTPUTFILE, ofstream::out);
+            async = new AsyncStreamBuf(out);
+        }
+        ostream csv(async);
+        RowWriter rows(csv, core._collapse, written != NULL);
+        core.LineUp();
+        int n = core._orders.size();
+        int sample = BENCH_SAMPLE; // "second" at which Schedule() is timed next
+        double taken = 0;
+        bench_clock::time_point start = bench_clock::now();
+        while (n > 0 && core._time < _ticks)
+        {
+            long long before = bench_allocs;
+            bench_counting = (allocs != NULL);
+            if (core._eventDriven)
+            {
+                core.SkipQuiet(rows);
+            }
+            n = core.Proceed(n, rows);
+            core.Retire();
+            bench_counting = false;
+            if (allocs)
+            {
+                allocs[0] += bench_allocs - before;
+                allocs[1] += (core._time > _steady) ? bench_allocs - before : 0;
+            }
+            if (schedule && core._time >= sample)
+            {
+                sample *= 2;
+                taken += seconds_since(start);
+                TimeSchedule(core, *schedule, *calls);
+                start = bench_clock::now();
+            }
+        }
+        rows.Flush();
+        taken += seconds_since(start);
+        done = core._orders.size() - n;
+        if (async)
+        {
+            async->Close();
+            delete async;
+            *written = out.tellp();
+            out.close();
+        }
+        return taken;
+    }
+    // Time Schedule() for every stove on copies of the kitchen
+    void TimeSchedule(Scheduler &core, double &schedule, long &calls)
+    {
+        for (int s = 0; s < core._stoves.size(); s++)
+        {
+            Scheduler copy = core;
+            bench_clock::time_point start = bench_clock::now();
+            for (int k = 0; k < BENCH_CALLS; k++)
+            {
+                copy.Schedule(s);
+            }
+            schedule += seconds_since(start);
+            calls += BENCH_CALLS;
+        }
+    }
+    Scheduler _proto;
+    int _ticks;
+    int _steady; // "second" from which allocations count as steady state
+};
+
+/* parse_reals() - parses a comma-separated list of numbers
+ *               - returns the numbers (empty if there is anything else)
+ */
+vector<double> parse_reals(const string &s)
+{
+    vector<double> list;
+    stringstream in(s);
+    string item;
+    while (getline(in, item, ','))
+    {
+        char *end;
+        double x = strtod(item.c_str(), &end);
+        if (item.empty() || *end != '\0')
+        {
+            return vector<double>();
+        }
+        list.push_back(x);
+    }
+    return list;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<int> dishes = {10, 1000, 100000};
+    vector<int> bursts = {1, 50};
+    vector<double> cooks = {0.5};
+    vector<int> steps = {3};
+    double load = 0.9; // offered load on the stoves
+    int ticks = 100000; // most "seconds" simulated per run
+    unsigned seed = 1;
+    string dir = "bench-work"; // where generated kitchens are written
+    string outFile = "bench.json";
+    Scheduler core;
+
+    // Parse command line options
+    for (int i = 1; i < argc; i++)
+    {
+        string opt = argv[i];
+        if (opt == "--event")
+        {
+            core.SetEventDriven(true);
+        }
+        else if ((opt == "--dishes" || opt == "--burst" || opt == "--steps") && i + 1 < argc)
+        {
+            vector<int> list = parse_list(argv[++i]);
+            if (list.empty() || *min_element(list.begin(), list.end()) < 1)
+            {
+                fatal_err("Option '" + opt + "' needs a list of positive numbers, e.g. 10,1000.", 7);
+            }
+            (opt == "--dishes" ? dishes : opt == "--burst" ? bursts : steps) = list;
+        }
+        else if (opt == "--cook" && i + 1 < argc)
+        {
+            cooks = parse_reals(argv[++i]);
+            if (cooks.empty() || *min_element(cooks.begin(), cooks.end()) < 0 || *max_element(cooks.begin(), cooks.end()) > 1)
+            {
+                fatal_err("Option '--cook' needs a list of shares from 0 to 1, e.g. 0.2,0.8.", 7);
+            }
+        }
+        else if (opt == "--load" && i + 1 < argc)
+        {
+            load = atof(argv[++i]);
+            if (load <= 0)
+            {
+                fatal_err("Option '--load' needs a positive number.", 7);
+            }
+        }
+        else if ((opt == "--stoves" || opt == "--ticks" || opt == "--seed") && i + 1 < argc)
+        {
+            int count = atoi(argv[++i]);
+            if (count < 1)
+            {
+                fatal_err("Option '" + opt + "' needs a positive count.", 7);
+            }
+            if (opt == "--stoves")
+            {
+                core.SetStoves(count);
+            }
+            else if (opt == "--ticks")
+            {
+                ticks = count;
+            }
+            else
+            {
+                seed = count;
+            }
+        }
+        else if (opt == "--dir" && i + 1 < argc)
+        {
+            dir = argv[++i];
+        }
+        else if (opt == "--out" && i + 1 < argc)
+        {
+            outFile = argv[++i];
+        }
+        else
+        {
+            fatal_err("Unknown option '" + opt + "'.", 7);
+        }
+    }
+
+    ofstream json(filesystem::absolute(outFile).c_str(), ofstream::out);
+    if (!json.is_open())
+    {
+        fatal_err("Benchmark results file could not be opened.", 6);
+    }
+    filesystem::create_directories(dir);
+    filesystem::current_path(dir); // recipes are read from recipes/ here
+    int stoves = core.GetStoves();
+
+    time_t now = time(NULL);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    json << "{" << endl;
+    json << "  \"context\": {" << endl;
+    json << "    \"date\": \"" << date << "\"," << endl;
+    json << "    \"num_cpus\": " << thread::hardware_concurrency() << "," << endl;
+    json << "    \"tick_kernel\": \"" << TickKernels::Get().GetName() << "\"," << endl;
+    json << "    \"stoves\": " << stoves << "," << endl;
+    json << "    \"load\": " << load << "," << endl;
+    json << "    \"max_ticks\": " << ticks << "," << endl;
+    json << "    \"event_driven\": " << (core.IsEventDriven() ? "true" : "false") << "," << endl;
+    json << "    \"seed\": " << seed << endl;
+    json << "  }," << endl;
+    json << "  \"benchmarks\": [" << endl;
+
+    Bench bench(core, ticks);
+    bool first = true;
+    for (int d : dishes)
+    {
+        for (int b : bursts)
+        {
+            for (double c : cooks)
+            {
+                for (int l : steps)
+                {
+                    Workload w(d, b, c, l);
+                    filesystem::remove_all(RECIPEDIR);
+                    w.Write(load, stoves, seed);
+                    json << (first ? "" : ",\n");
+                    bench.Run(w, json);
+                    first = false;
+                }
+            }
+        }
+    }
+    json << endl << "  ]" << endl << "}" << endl;
+    return 0;
+}
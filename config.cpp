@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include "mfq.cpp"
+
+#define BOOST_QUANTUM 120 // Time interval for priority boost
+
+using namespace std;
+
+/*
+ * SchedulerConfig - tunable scheduling parameters.
+ *
+ * Defaults are the original hard-coded values: 10 queues, the quantum
+ * table from Schedule() and a boost every BOOST_QUANTUM "seconds", under
+ * the MLFQ policy.
+ */
+class SchedulerConfig
+{
+public:
+    SchedulerConfig()
+    {
+        _queueCount = QUEUE_COUNT;
+        // Quantum per level, from the top level down
+        // -- Lower priority level queues => higher quantum
+        //     because they are less likely to be selected.
+        int q[] = {2, 3, 4, 6, 7, 8, 10, 11, 12, 14};
+        _quanta.assign(q, q + 10);
+        _boost = BOOST_QUANTUM;
+        _policy = "mlfq";
+    }
+
+    int GetQueueCount() // getter for number of priority levels
+    {
+        return _queueCount;
+    }
+    void SetQueueCount(int n) // setter for number of priority levels
+    {
+        // 1 up to MAX_QUEUES levels
+        _queueCount = (n < 1) ? 1 : (n > MAX_QUEUES) ? MAX_QUEUES : n;
+    }
+    int GetQuantum(int level) // getter for time quantum of a level
+    {
+        // Levels below the end of the table use its last entry
+        int fromTop = _queueCount - 1 - level;
+        return (fromTop < _quanta.size()) ? _quanta[fromTop] : _quanta.back();
+    }
+    vector<int>& GetQuanta() // getter for quantum table, top level first (reference)
+    {
+        return _quanta;
+    }
+    void SetQuanta(const vector<int> &q) // setter for quantum table, top level first
+    {
+        if (!q.empty())
+        {
+            _quanta = q;
+        }
+    }
+    int GetBoost() // getter for priority boost interval (0 if off)
+    {
+        return _boost;
+    }
+    void SetBoost(int b) // setter for priority boost interval
+    {
+        _boost = (b < 0) ? 0 : b;
+    }
+    string GetPolicy() // getter for name of scheduling policy
+    {
+        return _policy;
+    }
+    void SetPolicy(const string &p) // setter for name of scheduling policy
+    {
+        _policy = p;
+    }
+    string Describe() // one-line summary, e.g. "queues=10 quanta=2,3,4 boost=120"
+    {
+        ostringstream out;
+        if (_policy != "mlfq")
+        {
+            out << "policy=" << _policy << " ";
+        }
+        out << "queues=" << _queueCount << " quanta=";
+        for (int i = 0; i < _quanta.size(); i++)
+        {
+            out << ((i == 0) ? "" : ",") << _quanta[i];
+        }
+        out << " boost=" << _boost;
+        return out.str();
+    }
+private:
+    int _queueCount; // number of priority levels
+    vector<int> _quanta; // time quantum per level, top level first
+    int _boost; // "seconds" between priority boosts, 0 for none
+    string _policy; // scheduling policy, see PolicyRegistry
+};
@@ -1,17 +1,25 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include "spread.cpp"
 #define COOK 0
 #define PREP 1
-#define MAX_PRIORITY 10
+#define MAX_PRIORITY 32 // one priority per level, up to MAX_QUEUES
 
 using namespace std;
 
-enum dish_state {READY, PREPPING, ONSTOVE, NOTARRIVED, MOVING, DONE};
+enum dish_state {READY, PREPPING, ONSTOVE, NOTARRIVED, MOVING, PREPWAIT, DONE};
 
 class Task
 {
 public:
+    Task()
+    {
+        _type = COOK;
+        _time = 0; // nothing to do
+    }
     Task(int type, int duration)
     {
         _type = type; // COOK or PREP
@@ -21,7 +29,7 @@ public:
     {
         return _type;
     }
-    string GetStringType() // getter of type as string
+    string_view GetStringType() // getter of type as string
     {
         return (_type == COOK) ? "Cook" : "Prep";
     }
@@ -33,6 +41,10 @@ public:
     {
         _time--;
     }
+    void Step(int n) // execute n "seconds" of the task at once
+    {
+        _time -= n;
+    }
     bool IsDone() // return true if the task is done
     {
         return (_time <= 0);
@@ -42,110 +54,108 @@ private:
     int _time;
 };
 
-class Dish
+class Recipe
 {
 public:
     /*
      * Constructor
      */
-    Dish(string name, int arrival, int priority)
+    Recipe(vector<Task> &arena)
     {
-        _name = name; // MUST match filename for recipe
-        _arrivalTime = arrival; // "second" at which this dish is due to arrive
-        _waitingTime = 0; // hasn't waited yet
-        _priority = priority; // priority of dish used for scheduling algorithm
-        _ipriority = _priority; // initial priority of dish
-        _state = NOTARRIVED; // initial state is NotArrived always
+        _name = NULL; // set by the recipe book
+        _priority = 0;
+        _steps = &arena; // steps are added at the end of the arena
+        _first = arena.size();
+        _count = 0;
     }
-
-    // Getters and Setters
-    string GetName() // getter for name
+    const string& GetName() // getter for name of dishes with this recipe
     {
-        return _name;
+        return *_name;
     }
-    void SetName(string n) // setter for name
+    void SetName(const string &name) // setter for name (kept by the recipe book)
     {
-        _name = n;
+        _name = &name; // MUST match filename for recipe
     }
-    int GetArrival() // getter for arrival time
+    int GetPriority() // getter for initial priority of dishes with this recipe
     {
-        return _arrivalTime;
+        return _priority;
     }
-    int GetWaitingTime() // getter for waiting time
+    void SetPriority(int p) // setter for priority
     {
-        return _waitingTime;
+        _priority = p;
     }
-    void Wait() // incrementer for waiting time
+    int GetStepCount() // getter for number of steps
     {
-        _waitingTime++;
+        return _count;
     }
-    int GetPriority() // getter for priority
+    Task& GetStep(int k) // getter for step k, with its full duration (reference)
     {
-        return _priority;
+        return (*_steps)[_first + k];
     }
-    int GetInitPriority() // getter for initial priority
+    void AddStep(const Task &t, const Spread &spread = Spread()) // add a step (only to the recipe read last), and how its time varies
     {
-        return _ipriority;
+        _steps->push_back(t);
+        _count++;
+        if (!spread.IsFixed() || !_spreads.empty())
+        {
+            _spreads.resize(_count);
+            _spreads.back() = spread;
+        }
     }
-    void SetPriority(int p) // setter for priority
+    bool HasSpread() // returns true if the time of any step varies
     {
-        // if p is less than zero, p = 0
-        // elseif p is greater than MAX_PRIORITY (10), p = MAX_PRIORITY
-        // else p is p
-        p = (p < 0) ? 0 : (p > MAX_PRIORITY) ? MAX_PRIORITY : p;
-        _priority = p;
+        return !_spreads.empty();
     }
-    dish_state GetState() // getter for state
+    Spread GetSpread(int k) // getter for how the time of step k varies (Monte Carlo mode)
     {
-        return _state;
+        return (k < _spreads.size()) ? _spreads[k] : Spread();
     }
-    void SetState(dish_state s) // setter for state
+    Spread& GetJitter() // getter for how arrivals of dishes with this recipe vary (reference)
     {
-        _state = s;
+        return _jitter;
     }
-    vector<Task>& GetRecipe() // getter for recipe (returns reference)
+    void SetJitter(const Spread &s) // setter for jitter
     {
-        return _recipe;
+        _jitter = s;
     }
-    Task * GetNextTask() // get next unfinished task in recipe (reference)
+    int GetTotalTime() // getter for time of all steps together
     {
-        for (int i = 0; i < _recipe.size(); i++)
+        int total = 0;
+        for (int k = 0; k < _count; k++)
         {
-            // return the first task in recipe that is not yet done
-            if (_recipe[i].IsDone() == false)
-            {
-                return &(_recipe.at(i));
-            }
+            total += GetStep(k).GetTime();
         }
-        return NULL;
+        return total;
     }
-    bool IsDone() // returns true if all tasks are done
+private:
+    const string *_name; // name, stored once in the recipe book
+    int _priority;
+    vector<Task> *_steps; // arena with the steps of every recipe
+    int _first; // position of the first step in the arena
+    int _count; // number of steps
+    vector<Spread> _spreads; // how each step's time varies (empty if none does)
+    Spread _jitter; // how arrivals vary
+};
+
+// An order for a dish: what to cook and when it comes in (a line of the
+//  tasklist); it becomes a dish in a DishTable once in the kitchen
+class Order
+{
+public:
+    Order(Recipe *recipe, int arrival)
     {
-        // if all tasks are done, dish is done too
-        return (this->GetNextTask() == NULL) ? true : false;
+        _recipe = recipe;
+        _arrival = arrival;
     }
-    friend ostream& operator << (ostream &out, Dish &d)
+    Recipe * GetRecipe() // getter for recipe (shared, returns pointer)
     {
-        out << d.GetName() << "(";
-        Task * t = d.GetNextTask();
-        if (t)
-        {
-            out << t->GetStringType() << " - " << t->GetTime();
-        }
-        else
-        {
-            out << "Done";
-        }
-        out << ")";
-        return out;
+        return _recipe;
+    }
+    int GetArrival() // getter for arrival time
+    {
+        return _arrival;
     }
-
 private:
-    string _name;
-    int _arrivalTime; // time when dish arrives in queue
-    int _waitingTime; // amount of time spent in Ready queue
-    int _priority; // current priority level
-    int _ipriority; // initial priority level
-    dish_state _state; // current state (COOKING, DONE, PREPPING, etc.)
-    vector<Task> _recipe; // Recipe (list of Tasks)
+    Recipe *_recipe;
+    int _arrival;
 };
@@ -0,0 +1,438 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <climits>
+#include <stdexcept>
+#include <string>
+#include <charconv>
+#include <algorithm>
+#include "dish.cpp"
+#include "kernel.cpp"
+#include "snapshot.cpp"
+
+using namespace std;
+
+class DishTable;
+
+/*
+ * QueueLink - the place of a dish in the feedback queues (maintained by
+ *             FeedbackQueues).
+ */
+class QueueLink
+{
+public:
+    QueueLink()
+    {
+        _level = -1; // not in any scheduling queue yet
+        _qprev = -1;
+        _qnext = -1;
+        _queued = false;
+        _epoch = 0;
+    }
+private:
+    friend class FeedbackQueues;
+    int _qprev; // handle of previous dish in line, -1 if first
+    int _qnext; // handle of next dish in line, -1 if last
+    unsigned _epoch; // boost epoch in which _level was set
+    signed char _level; // queue level, -1 if not queued (at most MAX_QUEUES)
+    bool _queued; // true if in line for the stove
+};
+
+/*
+ * DishRef - one dish in a DishTable. It only refers to the dish: copies
+ *           refer to the same one.
+ */
+class DishRef
+{
+public:
+    DishRef(DishTable &t, int p) : _t(t), _p(p) { }
+
+    // Getters and Setters
+    const string& GetName(); // getter for name
+    int GetArrival(); // getter for arrival time
+    int GetWaitingTime(); // getter for waiting time
+    void Wait(int n = 1); // add n "seconds" of waiting time
+    int GetPriority(); // getter for priority
+    int GetInitPriority(); // getter for initial priority
+    int GetOrder(); // getter for number of the order (in the tasklist, or in the stream online)
+    int GetFirstCook(); // getter for "second" first on a stove (-1 if not yet)
+    void SetFirstCook(int t); // setter for "second" first on a stove
+    void SetPriority(int p); // setter for priority
+    dish_state GetState(); // getter for state
+    void SetState(dish_state s); // setter for state
+    Recipe * GetRecipe(); // getter for recipe (shared, returns pointer)
+    Task * GetNextTask(); // get next unfinished task in recipe (reference)
+    int GetTaskIndex(); // getter for index in recipe of next unfinished task
+    int Step(int n = 1); // execute up to n "seconds" of the next task
+    bool IsDone(); // returns true if all tasks are done
+    friend ostream& operator << (ostream &out, DishRef d)
+    {
+        out << d.GetName() << "(";
+        Task * t = d.GetNextTask();
+        if (t)
+        {
+            out << t->GetStringType() << " - " << t->GetTime();
+        }
+        else
+        {
+            out << "Done";
+        }
+        out << ")";
+        return out;
+    }
+    void AppendTo(string &out) // like <<, but appended to out (no allocation once out has room)
+    {
+        out += GetName();
+        out += '(';
+        Task * t = GetNextTask();
+        if (t)
+        {
+            char digits[16];
+            out += t->GetStringType();
+            out += " - ";
+            out.append(digits, to_chars(digits, digits + sizeof(digits), t->GetTime()).ptr);
+        }
+        else
+        {
+            out += "Done";
+        }
+        out += ')';
+    }
+private:
+    DishTable &_t;
+    int _p; // position in the table's arrays
+};
+
+/*
+ * DishTable - the dishes in the kitchen, by handle.
+ *
+ * A dish is added when it arrives and gets a free slot, if there is one
+ * (the one freed last), or a new one; its handle is the slot. Handles do
+ * not change while a dish is in the kitchen, and a slot is freed when its
+ * dish is released, to be given to the next dish that arrives. So the
+ * table is as big as the most dishes there have been in the kitchen at
+ * once, however long any one of them stays. Free slots are DONE, so the
+ * tick kernels pass over them. Handles say nothing about tasklist order:
+ * each dish keeps the number of its order (its place in the tasklist, or
+ * in the stream in online mode), which decides ties wherever the
+ * scheduler goes by tasklist order.
+ *
+ * The dishes in each state between arriving and done are also linked in
+ * a list of their own (kept up by DishRef::SetState()), so the scheduler
+ * can visit, say, the READY dishes without going through the table.
+ *
+ * Every property has an array of its own (state, priority, waiting time,
+ * task in progress, ...), so a loop over one property of many dishes
+ * reads contiguous memory and nothing else.
+ */
+class DishTable
+{
+public:
+    DishTable()
+    {
+        for (int st = 0; st < DONE; st++)
+        {
+            _first[st] = -1; // no dish in state st yet
+            _count[st] = 0;
+        }
+    }
+    int Add(Recipe *recipe, int arrival, int order) // put a dish that arrives in a slot, returns its handle
+    {
+        int h;
+        if (_free.empty())
+        {
+            h = _state.size();
+            Resize(h + 1);
+        }
+        else
+        {
+            h = _free.back();
+            _free.pop_back();
+        }
+        _order[h] = order; // number of its order
+        _recipe[h] = recipe; // shared with every dish of the same name
+        _arrival[h] = arrival; // "second" at which this dish is due to arrive
+        _wait[h] = 0; // hasn't waited yet
+        _priority[h] = recipe->GetPriority(); // priority used for scheduling
+        _firstCook[h] = -1; // not on a stove yet
+        _state[h] = NOTARRIVED; // initial state is NotArrived always
+        _next[h] = 0; // start from the first step of the recipe
+        _task[h] = recipe->GetStepCount() > 0 ? recipe->GetStep(0) : Task(COOK, 0);
+        _links[h] = QueueLink();
+        _lineKey[h] = LLONG_MIN; // not in a KeyedPolicy line
+        _statePrev[h] = -1; // in no state list until it arrives
+        _stateNext[h] = -1;
+        return h;
+    }
+    DishRef at(int h) // dish with handle h
+    {
+        if (h < 0 || h >= _state.size() || _order[h] < 0)
+        {
+            throw out_of_range("DishTable::at");
+        }
+        return DishRef(*this, h);
+    }
+    DishRef operator [] (int h) // dish with handle h, unchecked
+    {
+        return DishRef(*this, h);
+    }
+    QueueLink& Link(int h) // place in the feedback queues of dish h
+    {
+        return _links.at(h);
+    }
+    long long& LineKey(int h) // key in a KeyedPolicy line of dish h (LLONG_MIN if not in line)
+    {
+        return _lineKey.at(h);
+    }
+    int size() // number of slots (handles are below it)
+    {
+        return _state.size();
+    }
+    int Count(dish_state st) // number of dishes in state st (0 for NOTARRIVED and DONE)
+    {
+        return _count[st];
+    }
+    int First(dish_state st) // handle of a dish in state st, -1 if none
+    {
+        return _first[st];
+    }
+    int NextIn(int h) // handle of the next dish in the same state as dish h, -1 if none
+    {
+        return _stateNext.at(h);
+    }
+    // One "second" for the dishes that need no decision (see kernel.cpp);
+    //  the handles of the others go to rest, in tasklist order. Returns
+    //  their number.
+    int Tick(vector<int> &rest)
+    {
+        static_assert(sizeof(dish_state) == sizeof(int) && sizeof(Task) == 2 * sizeof(int), "kernels need int arrays");
+        int n = _state.size();
+        if (n == 0)
+        {
+            return 0;
+        }
+        if (rest.size() < n)
+        {
+            rest.resize(n);
+        }
+        int r = TickKernels::Get().GetKernel()((int *)&_state[0], (int *)&_task[0], &_wait[0], n, &rest[0]);
+        // Slots are reused, so handles are in no particular order
+        sort(rest.begin(), rest.begin() + r, [this](int a, int b) { return _order[a] < _order[b]; });
+        return r;
+    }
+    bool IsReleased(int h) // returns true if dish h has left the kitchen (its slot is free)
+    {
+        return _order.at(h) < 0;
+    }
+    void Release(int h) // dish h has left the kitchen; its slot goes to the next dish
+    {
+        _order.at(h) = -1;
+        _recipe[h] = NULL;
+        Restate(h, DONE); // idle lane for the kernels
+        _free.push_back(h);
+    }
+    // Save or restore every slot; recipes are not stored but taken from
+    //  the orders, by number
+    void Snap(Snapshot &s, vector<Order> &orders)
+    {
+        s.Field(_order);
+        s.Field(_arrival);
+        s.Field(_wait);
+        s.Field(_priority);
+        s.Field(_firstCook);
+        s.Field(_state);
+        s.Field(_next);
+        s.Field(_task);
+        s.Field(_links);
+        s.Field(_lineKey);
+        s.Field(_statePrev);
+        s.Field(_stateNext);
+        s.Field(_first);
+        s.Field(_count);
+        s.Field(_free);
+        if (s.IsLoading())
+        {
+            _recipe.assign(_order.size(), NULL);
+            for (int p = 0; p < _order.size(); p++)
+            {
+                if (_order[p] > -1 && _order[p] < orders.size())
+                {
+                    _recipe[p] = orders[_order[p]].GetRecipe();
+                }
+            }
+        }
+    }
+private:
+    friend class DishRef;
+    static bool Listed(dish_state st) // returns true if dishes in state st are in a state list
+    {
+        return st != NOTARRIVED && st != DONE;
+    }
+    void Restate(int h, dish_state st) // move dish h from the list of its state to that of st
+    {
+        dish_state was = _state[h];
+        if (was == st)
+        {
+            return;
+        }
+        if (Listed(was))
+        {
+            if (_statePrev[h] > -1)
+            {
+                _stateNext[_statePrev[h]] = _stateNext[h];
+            }
+            else
+            {
+                _first[was] = _stateNext[h];
+            }
+            if (_stateNext[h] > -1)
+            {
+                _statePrev[_stateNext[h]] = _statePrev[h];
+            }
+            _count[was]--;
+        }
+        _state[h] = st;
+        _statePrev[h] = -1;
+        _stateNext[h] = -1;
+        if (Listed(st))
+        {
+            // In front: the lists are in no particular order
+            _stateNext[h] = _first[st];
+            if (_first[st] > -1)
+            {
+                _statePrev[_first[st]] = h;
+            }
+            _first[st] = h;
+            _count[st]++;
+        }
+    }
+    void Resize(int n) // n slots for every property
+    {
+        _recipe.resize(n, NULL);
+        _order.resize(n, -1);
+        _arrival.resize(n);
+        _wait.resize(n);
+        _priority.resize(n);
+        _firstCook.resize(n);
+        _state.resize(n, DONE);
+        _next.resize(n);
+        _task.resize(n, Task(COOK, 0));
+        _links.resize(n);
+        _lineKey.resize(n, LLONG_MIN);
+        _statePrev.resize(n, -1);
+        _stateNext.resize(n, -1);
+    }
+    vector<Recipe *> _recipe; // Recipe (list of Tasks), shared
+    vector<int> _order; // number of the order the dish was made for (-1 if the slot is free)
+    vector<int> _arrival; // time when dish arrives in queue
+    vector<int> _wait; // amount of time spent in Ready queue
+    vector<int> _priority; // current priority level
+    vector<int> _firstCook; // "second" at which dish was first on a stove
+    vector<dish_state> _state; // current state (COOKING, DONE, PREPPING, etc.)
+    vector<int> _next; // index in recipe of first unfinished task
+    vector<Task> _task; // Task in progress, with time remaining
+    vector<QueueLink> _links; // Scheduling queue links
+    vector<long long> _lineKey; // Place in line (maintained by KeyedPolicy)
+    vector<int> _statePrev; // handle of previous dish in the same state, -1 if first
+    vector<int> _stateNext; // handle of next dish in the same state, -1 if last
+    int _first[DONE]; // handle of first dish in each state, -1 if none
+    int _count[DONE]; // number of dishes in each state
+    vector<int> _free; // free slots, the one freed last at the back
+};
+
+inline const string& DishRef::GetName()
+{
+    return _t._recipe[_p]->GetName();
+}
+inline int DishRef::GetArrival()
+{
+    return _t._arrival[_p];
+}
+inline int DishRef::GetWaitingTime()
+{
+    return _t._wait[_p];
+}
+inline void DishRef::Wait(int n)
+{
+    _t._wait[_p] += n;
+}
+inline int DishRef::GetPriority()
+{
+    return _t._priority[_p];
+}
+inline int DishRef::GetInitPriority()
+{
+    return _t._recipe[_p]->GetPriority(); // not kept per dish
+}
+inline int DishRef::GetOrder()
+{
+    return _t._order[_p];
+}
+inline int DishRef::GetFirstCook()
+{
+    return _t._firstCook[_p];
+}
+inline void DishRef::SetFirstCook(int t)
+{
+    _t._firstCook[_p] = t;
+}
+inline void DishRef::SetPriority(int p)
+{
+    // if p is less than zero, p = 0
+    // elseif p is greater than MAX_PRIORITY (32), p = MAX_PRIORITY
+    // else p is p
+    p = (p < 0) ? 0 : (p > MAX_PRIORITY) ? MAX_PRIORITY : p;
+    _t._priority[_p] = p;
+}
+inline dish_state DishRef::GetState()
+{
+    return _t._state[_p];
+}
+inline void DishRef::SetState(dish_state s)
+{
+    _t.Restate(_p, s); // also moves it to the list of its new state
+}
+inline Recipe * DishRef::GetRecipe()
+{
+    return _t._recipe[_p];
+}
+inline Task * DishRef::GetNextTask()
+{
+    // Tasks are done in order, so the cursor only ever moves forward;
+    //  only the task in progress is copied out of the shared recipe
+    Recipe *r = _t._recipe[_p];
+    int &next = _t._next[_p];
+    Task &current = _t._task[_p];
+    while (next < r->GetStepCount() && current.IsDone())
+    {
+        next++;
+        if (next < r->GetStepCount())
+        {
+            current = r->GetStep(next);
+        }
+    }
+    return (next < r->GetStepCount()) ? &current : NULL;
+}
+inline int DishRef::GetTaskIndex()
+{
+    GetNextTask();
+    return _t._next[_p];
+}
+inline int DishRef::Step(int n)
+{
+    // returns the "seconds" left over if the task finishes early
+    Task * t = GetNextTask();
+    if (t == NULL)
+    {
+        return n;
+    }
+    int used = (n < t->GetTime()) ? n : t->GetTime();
+    t->Step(used);
+    return n - used;
+}
+inline bool DishRef::IsDone()
+{
+    // if all tasks are done, dish is done too
+    return GetNextTask() == NULL;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <functional>
+
+using namespace std;
+
+enum event_type {EV_ARRIVE, EV_TASK, EV_QUANTUM, EV_BOOST};
+
+class SimEvent
+{
+public:
+    SimEvent(int time, event_type type, int dish)
+    {
+        _time = time; // "second" at which the event happens
+        _type = type; // what happens
+        _dish = dish; // index of affected dish (-1 if none)
+    }
+    int GetTime() const // getter for time
+    {
+        return _time;
+    }
+    event_type GetType() const // getter for type
+    {
+        return _type;
+    }
+    int GetDish() const // getter for dish index
+    {
+        return _dish;
+    }
+    bool operator > (const SimEvent &e) const // order by time for min-heap
+    {
+        return _time > e._time;
+    }
+private:
+    int _time;
+    event_type _type;
+    int _dish;
+};
+
+// Time-ordered event queue (earliest event on top)
+//  Events are hints: a stale event (e.g. completion of a preempted dish)
+//  only makes the simulation process one tick that turns out to be quiet.
+typedef priority_queue<SimEvent, vector<SimEvent>, greater<SimEvent> > EventQueue;
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <string>
+#include "dish.cpp"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define KERNEL_X86 // SSE2 and AVX2 kernels are built; CPUID picks one at run time
+#endif
+
+using namespace std;
+
+/*
+ * Tick kernels - one "second" for every dish in the kitchen that needs no
+ * decision. They work on three arrays of a DishTable: state, task in
+ * progress (type and time left, side by side) and waiting time.
+ *   READY dishes with time left wait one more "second";
+ *   PREPPING dishes with more than one "second" left prep for one;
+ *   PREPWAIT dishes with time left keep waiting for an assistant.
+ * The position of every other dish that has arrived and is not done is
+ * written to rest, in order, for the scheduler to take one at a time.
+ * Returns the number of positions written.
+ *
+ * All kernels give the same result; the widest one the CPU supports is
+ * used unless another one is picked with TickKernels::Set() (--kernel).
+ */
+typedef int (*tick_kernel)(int *state, int *task, int *wait, int n, int *rest);
+
+/* tick_range() - the scalar kernel for positions from up to (not incl.) to
+ *              - returns number of positions written to rest
+ */
+int tick_range(int *state, int *task, int *wait, int from, int to, int *rest)
+{
+    int r = 0;
+    for (int p = from; p < to; p++)
+    {
+        int s = state[p];
+        int &left = task[2 * p + 1];
+        if (s == READY && left > 0)
+        {
+            wait[p]++;
+        }
+        else if (s == PREPPING && left > 1)
+        {
+            left--;
+        }
+        else if (!(s == PREPWAIT && left > 0) && s != NOTARRIVED && s != DONE)
+        {
+            rest[r++] = p;
+        }
+    }
+    return r;
+}
+
+int tick_scalar(int *state, int *task, int *wait, int n, int *rest)
+{
+    return tick_range(state, task, wait, 0, n, rest);
+}
+
+#ifdef KERNEL_X86
+__attribute__((target("sse2")))
+int tick_sse2(int *state, int *task, int *wait, int n, int *rest)
+{
+    const __m128i ready = _mm_set1_epi32(READY);
+    const __m128i prepping = _mm_set1_epi32(PREPPING);
+    const __m128i prepwait = _mm_set1_epi32(PREPWAIT);
+    const __m128i notArrived = _mm_set1_epi32(NOTARRIVED);
+    const __m128i done = _mm_set1_epi32(DONE);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    int r = 0;
+    int p = 0;
+    for (; p + 4 <= n; p += 4)
+    {
+        __m128i s = _mm_loadu_si128((__m128i *)(state + p));
+        __m128i w = _mm_loadu_si128((__m128i *)(wait + p));
+        __m128i ta = _mm_loadu_si128((__m128i *)(task + 2 * p)); // tasks p, p+1
+        __m128i tb = _mm_loadu_si128((__m128i *)(task + 2 * p + 4)); // tasks p+2, p+3
+        __m128i left = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(ta), _mm_castsi128_ps(tb), _MM_SHUFFLE(3, 1, 3, 1)));
+
+        // Masks are all ones (-1) where true
+        __m128i waits = _mm_and_si128(_mm_cmpeq_epi32(s, ready), _mm_cmpgt_epi32(left, zero));
+        __m128i steps = _mm_and_si128(_mm_cmpeq_epi32(s, prepping), _mm_cmpgt_epi32(left, one));
+        __m128i idle = _mm_and_si128(_mm_cmpeq_epi32(s, prepwait), _mm_cmpgt_epi32(left, zero));
+        idle = _mm_or_si128(idle, _mm_or_si128(_mm_cmpeq_epi32(s, notArrived), _mm_cmpeq_epi32(s, done)));
+
+        _mm_storeu_si128((__m128i *)(wait + p), _mm_sub_epi32(w, waits));
+        // Spread the steps back over the time halves of the tasks
+        _mm_storeu_si128((__m128i *)(task + 2 * p), _mm_add_epi32(ta, _mm_unpacklo_epi32(zero, steps)));
+        _mm_storeu_si128((__m128i *)(task + 2 * p + 4), _mm_add_epi32(tb, _mm_unpackhi_epi32(zero, steps)));
+
+        int bits = ~_mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(_mm_or_si128(waits, steps), idle))) & 0xf;
+        for (; bits != 0; bits &= bits - 1)
+        {
+            rest[r++] = p + __builtin_ctz(bits);
+        }
+    }
+    return r + tick_range(state, task, wait, p, n, rest + r);
+}
+
+__attribute__((target("avx2")))
+int tick_avx2(int *state, int *task, int *wait, int n, int *rest)
+{
+    const __m256i ready = _mm256_set1_epi32(READY);
+    const __m256i prepping = _mm256_set1_epi32(PREPPING);
+    const __m256i prepwait = _mm256_set1_epi32(PREPWAIT);
+    const __m256i notArrived = _mm256_set1_epi32(NOTARRIVED);
+    const __m256i done = _mm256_set1_epi32(DONE);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    int r = 0;
+    int p = 0;
+    for (; p + 8 <= n; p += 8)
+    {
+        __m256i s = _mm256_loadu_si256((__m256i *)(state + p));
+        __m256i w = _mm256_loadu_si256((__m256i *)(wait + p));
+        __m256i ta = _mm256_loadu_si256((__m256i *)(task + 2 * p)); // tasks p to p+3
+        __m256i tb = _mm256_loadu_si256((__m256i *)(task + 2 * p + 8)); // tasks p+4 to p+7
+        // Times come out as 0 1 4 5 2 3 6 7; swapping the middle pairs
+        //  puts them in order (and back again)
+        __m256i left = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(ta), _mm256_castsi256_ps(tb), _MM_SHUFFLE(3, 1, 3, 1)));
+        left = _mm256_permute4x64_epi64(left, _MM_SHUFFLE(3, 1, 2, 0));
+
+        // Masks are all ones (-1) where true
+        __m256i waits = _mm256_and_si256(_mm256_cmpeq_epi32(s, ready), _mm256_cmpgt_epi32(left, zero));
+        __m256i steps = _mm256_and_si256(_mm256_cmpeq_epi32(s, prepping), _mm256_cmpgt_epi32(left, one));
+        __m256i idle = _mm256_and_si256(_mm256_cmpeq_epi32(s, prepwait), _mm256_cmpgt_epi32(left, zero));
+        idle = _mm256_or_si256(idle, _mm256_or_si256(_mm256_cmpeq_epi32(s, notArrived), _mm256_cmpeq_epi32(s, done)));
+
+        _mm256_storeu_si256((__m256i *)(wait + p), _mm256_sub_epi32(w, waits));
+        // Spread the steps back over the time halves of the tasks
+        __m256i spread = _mm256_permute4x64_epi64(steps, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)(task + 2 * p), _mm256_add_epi32(ta, _mm256_unpacklo_epi32(zero, spread)));
+        _mm256_storeu_si256((__m256i *)(task + 2 * p + 8), _mm256_add_epi32(tb, _mm256_unpackhi_epi32(zero, spread)));
+
+        int bits = ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_or_si256(_mm256_or_si256(waits, steps), idle))) & 0xff;
+        for (; bits != 0; bits &= bits - 1)
+        {
+            rest[r++] = p + __builtin_ctz(bits);
+        }
+    }
+    return r + tick_range(state, task, wait, p, n, rest + r);
+}
+#endif
+
+/*
+ * TickKernels - the kernels built into this program and the one in use
+ */
+class TickKernels
+{
+public:
+    static TickKernels& Get() // the kernels (picked on first use)
+    {
+        static TickKernels kernels;
+        return kernels;
+    }
+    tick_kernel GetKernel() // getter for kernel in use
+    {
+        return _kernel;
+    }
+    const string& GetName() // getter for name of kernel in use
+    {
+        return _name;
+    }
+    bool Set(const string &name) // use kernel called 'name', if built and supported
+    {
+        if (name == "scalar")
+        {
+            _kernel = tick_scalar;
+        }
+        #ifdef KERNEL_X86
+        else if (name == "sse2" && __builtin_cpu_supports("sse2"))
+        {
+            _kernel = tick_sse2;
+        }
+        else if (name == "avx2" && __builtin_cpu_supports("avx2"))
+        {
+            _kernel = tick_avx2;
+        }
+        #endif
+        else
+        {
+            return false;
+        }
+        _name = name;
+        return true;
+    }
+private:
+    TickKernels()
+    {
+        #ifdef KERNEL_X86
+        __builtin_cpu_init();
+        #endif
+        // Widest first
+        if (!Set("avx2") && !Set("sse2"))
+        {
+            Set("scalar");
+        }
+    }
+    tick_kernel _kernel;
+    string _name;
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <vector>
+#include "nodepool.cpp"
+
+using namespace std;
+
+/*
+ * DishLife - the life cycle of one dish, as a coroutine (see
+ *            BasicScheduler::Life()).
+ *
+ * It runs as soon as the dish arrives, up to the first thing it waits
+ * for, and goes on each time the event loop resumes it. Its frame comes
+ * from a FramePool.
+ */
+class DishLife
+{
+public:
+    class promise_type
+    {
+    public:
+        DishLife get_return_object()
+        {
+            return DishLife(coroutine_handle<promise_type>::from_promise(*this));
+        }
+        suspend_never initial_suspend() noexcept // runs right away, up to its first wait
+        {
+            return suspend_never();
+        }
+        suspend_always final_suspend() noexcept // kept until the event loop sees that it is done
+        {
+            return suspend_always();
+        }
+        void return_void()
+        {
+        }
+        void unhandled_exception()
+        {
+            terminate();
+        }
+        static void * operator new(size_t size)
+        {
+            return FramePool::Allocate(size);
+        }
+        static void operator delete(void *p, size_t size)
+        {
+            FramePool::Deallocate(p, size);
+        }
+    };
+    DishLife(DishLife &&o)
+    {
+        _h = o._h;
+        o._h = nullptr;
+    }
+    ~DishLife()
+    {
+        if (_h)
+        {
+            _h.destroy();
+        }
+    }
+    coroutine_handle<> Take() // hands over the coroutine (this no longer ends it)
+    {
+        coroutine_handle<> h = _h;
+        _h = nullptr;
+        return h;
+    }
+private:
+    DishLife(coroutine_handle<promise_type> h)
+    {
+        _h = h;
+    }
+    DishLife(const DishLife &); // not copyable
+    DishLife& operator = (const DishLife &);
+    coroutine_handle<promise_type> _h;
+};
+
+/*
+ * DishLives - the life cycle of each dish in a DishTable that has arrived
+ *             and is not done, by handle.
+ *
+ * A life ends, and its frame goes back to the pool, as soon as its dish
+ * is done. Frames belong to the simulation that started them, so a copy
+ * of a DishLives (of a scheduler that has not started yet) has none.
+ */
+class DishLives
+{
+public:
+    DishLives()
+    {
+    }
+    DishLives(const DishLives &)
+    {
+    }
+    DishLives& operator = (const DishLives &o)
+    {
+        if (this != &o)
+        {
+            Clear();
+        }
+        return *this;
+    }
+    ~DishLives()
+    {
+        Clear();
+    }
+    void Start(int h, DishLife &&life) // dish h goes on in life from its first wait
+    {
+        if (h >= _lives.size())
+        {
+            _lives.resize(h + 1);
+        }
+        _lives[h] = life.Take();
+        if (_lives[h].done())
+        {
+            End(h);
+        }
+    }
+    /* Resume() - goes on with the life of dish h, up to its next wait
+     *          - returns true if it is done now
+     */
+    bool Resume(int h)
+    {
+        coroutine_handle<> life = _lives.at(h);
+        life.resume();
+        if (life.done())
+        {
+            End(h);
+            return true;
+        }
+        return false;
+    }
+    void Clear() // ends every life, e.g. of a stretch of a split run that was cut short
+    {
+        for (int h = 0; h < _lives.size(); h++)
+        {
+            End(h);
+        }
+        _lives.clear();
+    }
+private:
+    void End(int h) // ends the life of dish h, if any
+    {
+        if (_lives[h])
+        {
+            _lives[h].destroy();
+            _lives[h] = nullptr;
+        }
+    }
+    vector<coroutine_handle<> > _lives; // by handle (null if none)
+};
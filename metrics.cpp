@@ -0,0 +1,285 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include "snapshot.cpp"
+
+#define SKETCH_ACCURACY 0.01 // relative error of quantiles
+
+using namespace std;
+
+/*
+ * QuantileSketch - streaming quantiles of non-negative times.
+ *
+ * Values go into buckets whose bounds grow by a constant factor (as in
+ * DDSketch), so memory depends on the largest value, not on how many
+ * there are, and every quantile is within SKETCH_ACCURACY of the true one.
+ * Up to about 50 each bucket holds a single whole number, so small times
+ * are exact.
+ */
+class QuantileSketch
+{
+public:
+    QuantileSketch()
+    {
+        _count = 0;
+        _zeros = 0;
+    }
+    void Add(int x) // add a value
+    {
+        _count++;
+        if (x <= 0)
+        {
+            _zeros++;
+            return;
+        }
+        int b = (int)ceil(log((double)x) / log(Gamma()));
+        if (b >= _buckets.size())
+        {
+            _buckets.resize(b + 1, 0);
+        }
+        _buckets[b]++;
+    }
+    long long GetCount() // number of values added
+    {
+        return _count;
+    }
+    double Quantile(double q) // value with a share q of the values at or below it (0 if none)
+    {
+        // Nearest rank
+        long long rank = max(1LL, (long long)ceil(q * _count));
+        long long seen = _zeros;
+        if (_count == 0 || seen >= rank)
+        {
+            return 0;
+        }
+        for (int b = 0; b < _buckets.size(); b++)
+        {
+            seen += _buckets[b];
+            if (seen >= rank)
+            {
+                // Middle of the bucket in relative terms, in whole "seconds"
+                return round(2 * pow(Gamma(), b) / (Gamma() + 1));
+            }
+        }
+        return 0;
+    }
+    void Merge(QuantileSketch &o) // add the values of o
+    {
+        _count += o._count;
+        _zeros += o._zeros;
+        if (o._buckets.size() > _buckets.size())
+        {
+            _buckets.resize(o._buckets.size(), 0);
+        }
+        for (int b = 0; b < o._buckets.size(); b++)
+        {
+            _buckets[b] += o._buckets[b];
+        }
+    }
+    void Snap(Snapshot &s) // save or restore the counts
+    {
+        s.Field(_count);
+        s.Field(_zeros);
+        s.Field(_buckets);
+    }
+private:
+    static double Gamma() // ratio of bucket bounds
+    {
+        return (1 + SKETCH_ACCURACY) / (1 - SKETCH_ACCURACY);
+    }
+    long long _count;
+    long long _zeros; // values of 0
+    vector<long long> _buckets; // bucket b holds values in (Gamma^(b-1), Gamma^b]
+};
+
+/*
+ * TimeMetrics - turnaround, response and waiting times of a group of
+ *               dishes: averages and percentiles
+ */
+class TimeMetrics
+{
+public:
+    TimeMetrics()
+    {
+        _count = 0;
+        _turnaround = 0;
+        _response = 0;
+        _wait = 0;
+    }
+    void Add(int turnaround, int response, int wait) // a dish is done (response < 0: never cooked)
+    {
+        _count++;
+        _turnaround += turnaround;
+        _wait += wait;
+        _turnaroundQ.Add(turnaround);
+        _waitQ.Add(wait);
+        if (response >= 0)
+        {
+            _response += response;
+            _responseQ.Add(response);
+        }
+    }
+    long long GetCount() // number of dishes done
+    {
+        return _count;
+    }
+    double GetTurnaround() // average turnaround time
+    {
+        return _count ? (double)_turnaround / _count : 0;
+    }
+    double GetResponse() // average response time of dishes that were cooked
+    {
+        return _responseQ.GetCount() ? (double)_response / _responseQ.GetCount() : 0;
+    }
+    double GetWait() // average waiting time
+    {
+        return _count ? (double)_wait / _count : 0;
+    }
+    QuantileSketch& GetTurnaroundQ() // getter for turnaround time quantiles (reference)
+    {
+        return _turnaroundQ;
+    }
+    QuantileSketch& GetResponseQ() // getter for response time quantiles (reference)
+    {
+        return _responseQ;
+    }
+    QuantileSketch& GetWaitQ() // getter for waiting time quantiles (reference)
+    {
+        return _waitQ;
+    }
+    string Describe() // one-line summary for the performance log
+    {
+        ostringstream out;
+        out << "dishes=" << _count << " turnaround=" << GetTurnaround() << " response=" << GetResponse()
+            << " wait=" << GetWait() << " wait p50/p95/p99=" << Percentiles(_waitQ);
+        return out.str();
+    }
+    static string Percentiles(QuantileSketch &q) // e.g. "3 / 17 / 40"
+    {
+        ostringstream out;
+        out << q.Quantile(0.50) << " / " << q.Quantile(0.95) << " / " << q.Quantile(0.99);
+        return out.str();
+    }
+    void Merge(TimeMetrics &o) // add the dishes of o
+    {
+        _count += o._count;
+        _turnaround += o._turnaround;
+        _response += o._response;
+        _wait += o._wait;
+        _turnaroundQ.Merge(o._turnaroundQ);
+        _responseQ.Merge(o._responseQ);
+        _waitQ.Merge(o._waitQ);
+    }
+    void Snap(Snapshot &s) // save or restore sums and sketches
+    {
+        s.Field(_count);
+        s.Field(_turnaround);
+        s.Field(_response);
+        s.Field(_wait);
+        _turnaroundQ.Snap(s);
+        _responseQ.Snap(s);
+        _waitQ.Snap(s);
+    }
+private:
+    long long _count;
+    long long _turnaround; // sums of times
+    long long _response;
+    long long _wait;
+    QuantileSketch _turnaroundQ;
+    QuantileSketch _responseQ;
+    QuantileSketch _waitQ;
+};
+
+/*
+ * DishMetrics - times of every dish done, overall, by dish name and by
+ *               initial priority.
+ *
+ *   turnaround - "seconds" from arrival until done, both included
+ *   response   - "seconds" from arrival until first on a stove
+ *   waiting    - "seconds" in line for a stove
+ */
+class DishMetrics
+{
+public:
+    void Add(const string &name, int priority, int turnaround, int response, int wait) // a dish is done
+    {
+        _all.Add(turnaround, response, wait);
+        _byName[name].Add(turnaround, response, wait);
+        _byPriority[priority].Add(turnaround, response, wait);
+    }
+    TimeMetrics& GetAll() // getter for metrics of all dishes (reference)
+    {
+        return _all;
+    }
+    void Write(ostream &out) // add the metrics to a performance log
+    {
+        out << "Average Turnaround Time       : " << _all.GetTurnaround() << endl;
+        out << "Average Response Time         : " << _all.GetResponse() << endl;
+        out << "Turnaround p50/p95/p99        : " << TimeMetrics::Percentiles(_all.GetTurnaroundQ()) << endl;
+        out << "Response p50/p95/p99          : " << TimeMetrics::Percentiles(_all.GetResponseQ()) << endl;
+        out << "Waiting Time p50/p95/p99      : " << TimeMetrics::Percentiles(_all.GetWaitQ()) << endl;
+        for (map<string, TimeMetrics>::iterator it = _byName.begin(); it != _byName.end(); ++it)
+        {
+            out << left << setw(30) << "Dish " + it->first << ": " << it->second.Describe() << endl;
+        }
+        // Highest priority first
+        for (map<int, TimeMetrics>::reverse_iterator it = _byPriority.rbegin(); it != _byPriority.rend(); ++it)
+        {
+            out << left << setw(30) << "Priority " + to_string(it->first) << ": " << it->second.Describe() << endl;
+        }
+    }
+    void Merge(DishMetrics &o) // add the dishes of o
+    {
+        _all.Merge(o._all);
+        for (map<string, TimeMetrics>::iterator it = o._byName.begin(); it != o._byName.end(); ++it)
+        {
+            _byName[it->first].Merge(it->second);
+        }
+        for (map<int, TimeMetrics>::iterator it = o._byPriority.begin(); it != o._byPriority.end(); ++it)
+        {
+            _byPriority[it->first].Merge(it->second);
+        }
+    }
+    void Snap(Snapshot &s) // save or restore every group
+    {
+        if (s.IsLoading())
+        {
+            _byName.clear();
+            _byPriority.clear();
+        }
+        _all.Snap(s);
+        vector<string> names;
+        for (map<string, TimeMetrics>::iterator it = _byName.begin(); it != _byName.end(); ++it)
+        {
+            names.push_back(it->first);
+        }
+        long long n = names.size();
+        s.Field(n);
+        for (long long k = 0; k < n && s.IsGood(); k++)
+        {
+            string name = s.IsLoading() ? "" : names[k];
+            s.Field(name);
+            _byName[name].Snap(s);
+        }
+        vector<int> priorities;
+        for (map<int, TimeMetrics>::iterator it = _byPriority.begin(); it != _byPriority.end(); ++it)
+        {
+            priorities.push_back(it->first);
+        }
+        s.Field(priorities);
+        for (int k = 0; k < priorities.size(); k++)
+        {
+            _byPriority[priorities[k]].Snap(s);
+        }
+    }
+private:
+    TimeMetrics _all;
+    map<string, TimeMetrics> _byName;
+    map<int, TimeMetrics> _byPriority;
+};
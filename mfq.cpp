@@ -0,0 +1,194 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include "dishtable.cpp"
+
+#define QUEUE_COUNT 10 // default number of priority levels
+#define MAX_QUEUES 32 // most priority levels there can be (see _nonEmpty)
+
+using namespace std;
+
+/*
+ * FeedbackQueues - the multilevel feedback queues, one FIFO per level.
+ *
+ * The lists are intrusive: links and level live in the DishTable, so every
+ * operation is O(1). Only dishes waiting for the stove (READY/ONSTOVE) are
+ * linked. A dish away from the stove (PREPPING/MOVING) is "parked": it
+ * keeps its level but has no place in line. That is all the scheduler ever
+ * needs, because a dish always goes to the back of its queue when it comes
+ * back for the stove.
+ *
+ * A priority boost splices every list onto the top one and bumps an epoch
+ * counter instead of visiting dishes: a dish whose level was set before
+ * the latest boost is at the top level, wherever its stale _level says.
+ */
+class FeedbackQueues
+{
+public:
+    FeedbackQueues()
+    {
+        for (int i = 0; i < MAX_QUEUES; i++)
+        {
+            _head[i] = -1;
+            _tail[i] = -1;
+            _length[i] = 0;
+        }
+        _nonEmpty = 0; // bit i is set iff queue i has a dish in line
+        _epoch = 0; // no boosts yet
+        _boostTop = 0;
+    }
+
+    void Enqueue(DishTable &d, int i, int level) // put dish i at the back of queue 'level'
+    {
+        Unlink(d, i);
+        QueueLink &x = d.Link(i);
+        x._level = level;
+        x._epoch = _epoch;
+        x._qprev = _tail[level];
+        x._qnext = -1;
+        x._queued = true;
+        if (_tail[level] > -1)
+        {
+            d.Link(_tail[level])._qnext = i;
+        }
+        else
+        {
+            _head[level] = i;
+            _nonEmpty |= 1u << level;
+        }
+        _tail[level] = i;
+        _length[level]++;
+    }
+    void Park(DishTable &d, int i, int level) // keep dish i in queue 'level', out of line
+    {
+        Unlink(d, i);
+        d.Link(i)._level = level;
+        d.Link(i)._epoch = _epoch;
+    }
+    void Unlink(DishTable &d, int i) // take dish i out of line, keeping its level
+    {
+        QueueLink &x = d.Link(i);
+        if (!x._queued)
+        {
+            return;
+        }
+        int level = GetLevel(d, i);
+        if (x._qprev > -1)
+        {
+            d.Link(x._qprev)._qnext = x._qnext;
+        }
+        else
+        {
+            _head[level] = x._qnext;
+        }
+        if (x._qnext > -1)
+        {
+            d.Link(x._qnext)._qprev = x._qprev;
+        }
+        else
+        {
+            _tail[level] = x._qprev;
+        }
+        if (_head[level] == -1)
+        {
+            _nonEmpty &= ~(1u << level);
+        }
+        _length[level]--;
+        x._qprev = -1;
+        x._qnext = -1;
+        x._queued = false;
+    }
+    void Remove(DishTable &d, int i) // take dish i out of the queues entirely
+    {
+        Unlink(d, i);
+        d.Link(i)._level = -1;
+    }
+    int GetLevel(DishTable &d, int i) // queue level of dish i (-1 if not queued)
+    {
+        QueueLink &x = d.Link(i);
+        return (x._level > -1 && x._epoch != _epoch) ? _boostTop : x._level;
+    }
+    void Boost(DishTable &d, int top) // move every queued dish to level 'top'
+    {
+        // Lines are appended to the top one highest level first, so
+        //  dishes keep their relative order of priority
+        for (int level = top - 1; level >= 0; level--)
+        {
+            if (_head[level] == -1)
+            {
+                continue;
+            }
+            if (_head[top] == -1)
+            {
+                _head[top] = _head[level];
+            }
+            else
+            {
+                d.Link(_tail[top])._qnext = _head[level];
+                d.Link(_head[level])._qprev = _tail[top];
+            }
+            _tail[top] = _tail[level];
+            _length[top] += _length[level];
+            _head[level] = -1;
+            _tail[level] = -1;
+            _length[level] = 0;
+        }
+        _nonEmpty = (_head[top] > -1) ? 1u << top : 0;
+        // Parked dishes and stale levels catch up through the epoch
+        _epoch++;
+        _boostTop = top;
+    }
+    int TopLevel() // highest level with a dish in line (-1 if none)
+    {
+        return (_nonEmpty == 0) ? -1 : 31 - __builtin_clz(_nonEmpty);
+    }
+    int Front(int level) // first dish in line at 'level' (-1 if none)
+    {
+        return _head[level];
+    }
+    int GetLength(int level) // number of dishes in line at 'level'
+    {
+        return _length[level];
+    }
+    int Next(DishTable &d, int i) // dish in line after dish i (-1 if none)
+    {
+        return d.Link(i)._qnext;
+    }
+    int LevelBelow(int level) // highest level under 'level' with a dish in line (-1 if none)
+    {
+        unsigned below = _nonEmpty & ((1u << level) - 1);
+        return (below == 0) ? -1 : 31 - __builtin_clz(below);
+    }
+    void Snap(Snapshot &s) // save or restore the lines (links are in the DishTable)
+    {
+        s.Field(_head);
+        s.Field(_tail);
+        s.Field(_length);
+        s.Field(_nonEmpty);
+        s.Field(_epoch);
+        s.Field(_boostTop);
+    }
+    void Print(DishTable &d, ostream &out) // dump queue contents (for debugging)
+    {
+        for (int i = 0; i < MAX_QUEUES; i++)
+        {
+            if (_head[i] == -1)
+            {
+                continue;
+            }
+            out << "Q" << i << ": ";
+            for (int j = _head[i]; j > -1; j = d.Link(j)._qnext)
+            {
+                out << j << ", ";
+            }
+        }
+    }
+private:
+    int _head[MAX_QUEUES]; // index of first dish in line per level
+    int _tail[MAX_QUEUES]; // index of last dish in line per level
+    int _length[MAX_QUEUES]; // number of dishes in line per level
+    unsigned _nonEmpty; // bitmask of levels with dishes in line
+    unsigned _epoch; // number of boosts so far
+    int _boostTop; // level the boosts move dishes to
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <cmath>
+#include "dish.cpp"
+#include "spread.cpp"
+
+using namespace std;
+
+/*
+ * Replica - the orders of one Monte Carlo replication: every order of the
+ *           tasklist with its arrival and step times drawn anew.
+ *
+ * A dish whose recipe has spread steps gets a recipe of its own, sharing
+ * the name (so it still counts as the same dish) and the priority of the
+ * one in the recipe book; the others keep pointing into the book. Draws
+ * are taken order by order, in tasklist order, so that a stream always
+ * gives the same replication.
+ */
+class Replica
+{
+public:
+    /* Constructor - arguments are orders of the tasklist, jitter of
+     *               recipes without one & random number stream
+     */
+    Replica(vector<Order> &orders, Spread &jitter, SpreadRng &rng)
+    {
+        _orders.reserve(orders.size());
+        for (int i = 0; i < orders.size(); i++)
+        {
+            Recipe *base = orders[i].GetRecipe();
+            Spread &j = base->GetJitter().IsFixed() ? jitter : base->GetJitter();
+            int at = max(1, orders[i].GetArrival() + j.Offset(rng));
+            Recipe *r = base;
+            if (base->HasSpread())
+            {
+                _recipes.emplace_back(_steps);
+                r = &_recipes.back();
+                r->SetName(base->GetName());
+                r->SetPriority(base->GetPriority());
+                for (int k = 0; k < base->GetStepCount(); k++)
+                {
+                    Task &t = base->GetStep(k);
+                    r->AddStep(Task(t.GetType(), base->GetSpread(k).Sample(t.GetTime(), rng)));
+                }
+            }
+            _orders.push_back(Order(r, at));
+        }
+    }
+    vector<Order>& GetOrders() // getter for the drawn orders (reference)
+    {
+        return _orders;
+    }
+private:
+    vector<Order> _orders;
+    deque<Recipe> _recipes; // recipes of dishes with drawn step times
+    vector<Task> _steps; // steps of those recipes
+};
+
+/*
+ * Estimate - one metric over all replications: its mean with a 95%
+ *            confidence interval, and its spread.
+ */
+class Estimate
+{
+public:
+    void Add(double x) // add the value of one replication
+    {
+        _values.push_back(x);
+    }
+    int GetCount() // number of replications
+    {
+        return _values.size();
+    }
+    double GetMean() // mean over all replications
+    {
+        double sum = 0;
+        for (int r = 0; r < _values.size(); r++)
+        {
+            sum += _values[r];
+        }
+        return _values.empty() ? 0 : sum / _values.size();
+    }
+    double GetHalfWidth() // half width of the 95% confidence interval of the mean (0 if fewer than 2 values)
+    {
+        int n = _values.size();
+        if (n < 2)
+        {
+            return 0;
+        }
+        double mean = GetMean();
+        double ss = 0;
+        for (int r = 0; r < n; r++)
+        {
+            ss += (_values[r] - mean) * (_values[r] - mean);
+        }
+        return StudentT(n - 1) * sqrt(ss / (n - 1) / n);
+    }
+    double Quantile(double q) // value with a share q of the replications at or below it
+    {
+        if (_values.empty())
+        {
+            return 0;
+        }
+        vector<double> sorted = _values;
+        sort(sorted.begin(), sorted.end());
+        // Nearest rank
+        long long rank = max(1LL, (long long)ceil(q * sorted.size()));
+        return sorted[rank - 1];
+    }
+    string Describe() // e.g. "812.4 +/- 3.1 (95% CI 809.3 - 815.5), p5/p95 790 / 836"
+    {
+        ostringstream out;
+        double mean = GetMean();
+        double h = GetHalfWidth();
+        out << mean << " +/- " << h << " (95% CI " << mean - h << " - " << mean + h << ")";
+        out << ", p5/p95 " << Quantile(0.05) << " / " << Quantile(0.95);
+        return out.str();
+    }
+private:
+    /* StudentT() - returns the two-sided 95% critical value of Student's t
+     *              with df degrees of freedom
+     */
+    static double StudentT(int df)
+    {
+        static const double table[30] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                         2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                         2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+        if (df <= 30)
+        {
+            return table[df - 1];
+        }
+        // Cornish-Fisher expansion around the normal quantile
+        double z = 1.959964;
+        return z + (z * z * z + z) / (4.0 * df) + (5 * pow(z, 5) + 16 * z * z * z + 3 * z) / (96.0 * df * df);
+    }
+    vector<double> _values; // by replication
+};
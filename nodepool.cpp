@@ -0,0 +1,217 @@
+#pragma once
+
+#include <vector>
+#include <set>
+#include <functional>
+#include <new>
+#include <utility>
+#include <mutex>
+
+using namespace std;
+
+/*
+ * NodePool - allocator for node-based containers (set, map) that keeps
+ *            the nodes handed back and gives them out again, so that a
+ *            container whose size goes up and down stops calling the heap
+ *            once it has been as large as it gets.
+ *
+ * Free nodes are kept per thread and node type, and go back to the heap
+ * when the thread ends. A node may be freed on another thread than the
+ * one it came from; it is then reused there.
+ */
+template <class T>
+class NodePool
+{
+public:
+    typedef T value_type;
+    NodePool() { }
+    template <class U>
+    NodePool(const NodePool<U> &) { }
+    T * allocate(size_t n)
+    {
+        vector<void *> &free = Free();
+        if (n == 1 && !free.empty())
+        {
+            void *p = free.back();
+            free.pop_back();
+            return (T *)p;
+        }
+        return (T *)::operator new(n * sizeof(T));
+    }
+    void deallocate(T *p, size_t n)
+    {
+        if (n == 1)
+        {
+            Free().push_back(p);
+            return;
+        }
+        ::operator delete(p);
+    }
+    template <class U>
+    bool operator == (const NodePool<U> &) const // any pool can free the nodes of any other
+    {
+        return true;
+    }
+    template <class U>
+    bool operator != (const NodePool<U> &) const
+    {
+        return false;
+    }
+private:
+    struct Nodes
+    {
+        ~Nodes()
+        {
+            for (size_t k = 0; k < free.size(); k++)
+            {
+                ::operator delete(free[k]);
+            }
+        }
+        vector<void *> free;
+    };
+    static vector<void *>& Free() // free nodes of this thread
+    {
+        static thread_local Nodes nodes;
+        return nodes.free;
+    }
+};
+
+// A set whose nodes are recycled
+template <class T>
+using PooledSet = set<T, less<T>, NodePool<T> >;
+
+/*
+ * FramePool - like NodePool, for coroutine frames (see DishLife), whose
+ *             size is only known when one is made. Frames are cut from
+ *             chunks of FRAMES_PER_CHUNK, so they carry no heap header,
+ *             and frames handed back are kept by size and given out
+ *             again, so dishes that come and go reuse the frames of
+ *             dishes that are done. A free frame holds the next free
+ *             frame of its size.
+ *
+ * Free frames are kept per thread. A frame may outlive the thread that
+ * made it (a split run goes on with a stretch simulated on another
+ * thread), so chunks are shared and go back to the heap only at exit;
+ * the free frames of a thread that ends are taken up by the next thread
+ * that needs frames of their size.
+ */
+#define FRAMES_PER_CHUNK 256
+
+class FramePool
+{
+public:
+    static void * Allocate(size_t size)
+    {
+        size = Round(size);
+        void *&free = Mine().Head(size);
+        if (free == NULL)
+        {
+            free = Shared().Take(size);
+        }
+        void *p = free;
+        free = *(void **)p;
+        return p;
+    }
+    static void Deallocate(void *p, size_t size)
+    {
+        void *&free = Mine().Head(Round(size));
+        *(void **)p = free;
+        free = p;
+    }
+private:
+    // Free frames of each size, as lists (there are only a few sizes)
+    struct Lists
+    {
+        void *& Head(size_t size) // first free frame with the given size (NULL if none)
+        {
+            for (size_t k = 0; k < bySize.size(); k++)
+            {
+                if (bySize[k].first == size)
+                {
+                    return bySize[k].second;
+                }
+            }
+            bySize.push_back(make_pair(size, (void *)NULL));
+            return bySize.back().second;
+        }
+        vector<pair<size_t, void *> > bySize;
+    };
+    // Chunks of all threads, and free frames of threads that have ended
+    struct Chunks
+    {
+        ~Chunks()
+        {
+            for (size_t c = 0; c < chunks.size(); c++)
+            {
+                ::operator delete(chunks[c]);
+            }
+        }
+        void * Take(size_t size) // a list of free frames with the given size
+        {
+            lock_guard<mutex> hold(lock);
+            void *&spare = spares.Head(size);
+            if (spare != NULL)
+            {
+                void *list = spare;
+                spare = NULL;
+                return list;
+            }
+            char *chunk = (char *)::operator new(size * FRAMES_PER_CHUNK);
+            chunks.push_back(chunk);
+            void *list = NULL;
+            for (int f = FRAMES_PER_CHUNK - 1; f >= 0; f--)
+            {
+                *(void **)(chunk + f * size) = list;
+                list = chunk + f * size;
+            }
+            return list;
+        }
+        void Give(Lists &free) // takes up the free frames of a thread that ends
+        {
+            lock_guard<mutex> hold(lock);
+            for (size_t k = 0; k < free.bySize.size(); k++)
+            {
+                void *list = free.bySize[k].second;
+                if (list == NULL)
+                {
+                    continue;
+                }
+                void *last = list;
+                while (*(void **)last != NULL)
+                {
+                    last = *(void **)last;
+                }
+                void *&spare = spares.Head(free.bySize[k].first);
+                *(void **)last = spare;
+                spare = list;
+            }
+        }
+        mutex lock;
+        vector<void *> chunks;
+        Lists spares;
+    };
+    struct Local : Lists
+    {
+        ~Local()
+        {
+            Shared().Give(*this);
+        }
+    };
+    static size_t Round(size_t size) // size of a frame rounded up, so frames cut from a chunk stay aligned
+    {
+        const size_t align = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+        return (size + align - 1) / align * align;
+    }
+    static Chunks& Shared()
+    {
+        static Chunks chunks;
+        return chunks;
+    }
+    static Lists& Mine() // free frames of this thread
+    {
+        // The chunks must go after the last thread is done with them
+        Shared();
+        static thread_local Local free;
+        return free;
+    }
+};
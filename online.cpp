@@ -0,0 +1,171 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <chrono>
+#ifndef _WIN32
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+#include "recipe.cpp"
+#include "textfile.cpp"
+
+#define FEED_CHUNK 4096 // bytes read from the order source at a time
+
+using namespace std;
+
+void fatal_err(const string &s, int code);
+
+/* open_order_source() - opens where orders come from in online mode
+ *                     - argument is "-" for stdin, or the path of a UNIX
+ *                       domain socket to listen on (for one client)
+ *                     - returns file descriptor to read orders from
+ */
+int open_order_source(const string &source)
+{
+    #ifdef _WIN32
+    fatal_err("Online mode is not supported on this platform.", 7);
+    return -1;
+    #else
+    if (source == "-")
+    {
+        return 0;
+    }
+    sockaddr_un addr;
+    if (source.size() >= sizeof(addr.sun_path))
+    {
+        fatal_err("Socket path '" + source + "' is too long.", 1);
+    }
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, source.c_str());
+    unlink(source.c_str());
+    if (server < 0 || bind(server, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(server, 1) < 0)
+    {
+        fatal_err("Socket '" + source + "' could not be opened.", 1);
+    }
+    // Standard output is for the rows
+    cerr << "Waiting for orders on " << source << endl;
+    int client = accept(server, NULL, NULL);
+    close(server);
+    unlink(source.c_str());
+    if (client < 0)
+    {
+        fatal_err("Socket '" + source + "' could not be opened.", 1);
+    }
+    return client;
+    #endif
+}
+
+/*
+ * OrderFeed - orders ("<dish name> [arrival time]" per line) coming in
+ *             while the simulation runs.
+ *
+ * Bad orders are reported on stderr and skipped; a live dispatcher does
+ * not stop for one typo.
+ */
+class OrderFeed
+{
+public:
+    OrderFeed(int fd, RecipeBook &book) : _book(book)
+    {
+        _fd = fd;
+        _open = true;
+        _row = 0;
+    }
+    bool IsOpen() // returns true until the source has closed
+    {
+        return _open;
+    }
+    void Wait(int ms) // wait up to ms milliseconds (-1 for no limit) for input and read it
+    {
+        #ifndef _WIN32
+        if (!_open)
+        {
+            return;
+        }
+        pollfd p;
+        p.fd = _fd;
+        p.events = POLLIN;
+        p.revents = 0;
+        if (poll(&p, 1, ms) <= 0)
+        {
+            return;
+        }
+        char chunk[FEED_CHUNK];
+        ssize_t got = read(_fd, chunk, FEED_CHUNK);
+        if (got <= 0)
+        {
+            _open = false;
+            if (_fd > 0)
+            {
+                close(_fd);
+            }
+            // A last order without newline still counts
+            if (!_pending.empty())
+            {
+                _pending += '\n';
+            }
+            return;
+        }
+        _pending.append(chunk, got);
+        #endif
+    }
+    bool NextOrder(Recipe *&recipe, int &arrival) // take the next complete order read so far
+    {
+        // arrival is 0 if the order did not say
+        size_t end;
+        while ((end = _pending.find('\n')) != string::npos)
+        {
+            string line = _pending.substr(0, end);
+            _pending.erase(0, end + 1);
+            _row++;
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            if (line.empty())
+            {
+                continue;
+            }
+            string_view order = line;
+            size_t x = order.find(' ');
+            string_view name = order.substr(0, x);
+            arrival = 0;
+            if (x != string_view::npos)
+            {
+                size_t y = x + 1;
+                if (!LineReader::ParseInt(order, y, arrival) || arrival < 1)
+                {
+                    cerr << "Order " << _row << " ignored: invalid arrival time at column " << y << "." << endl;
+                    continue;
+                }
+            }
+            string error;
+            recipe = _book.Find(name, error);
+            if (recipe == NULL && error.empty())
+            {
+                cerr << "Order " << _row << " ignored: no recipe for '" << name << "'." << endl;
+                continue;
+            }
+            if (recipe == NULL)
+            {
+                cerr << "Order " << _row << " ignored: " << error << endl;
+                continue;
+            }
+            return true;
+        }
+        return false;
+    }
+private:
+    RecipeBook &_book;
+    int _fd;
+    bool _open;
+    string _pending; // input read but not yet taken as orders
+    int _row; // orders (lines) taken so far
+};
@@ -0,0 +1,397 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <set>
+#include <climits>
+#include <tuple>
+#include "dishtable.cpp"
+#include "mfq.cpp"
+#include "config.cpp"
+#include "nodepool.cpp"
+
+#define QUANTUM_NONE (1 << 30) // quantum of policies that never preempt
+
+using namespace std;
+
+/*
+ * Scheduling policies.
+ *
+ * The scheduler is a template on its policy, so every policy has the same
+ * (non-virtual) member functions:
+ *   Arrive(d, i, ready, c) - dish i arrives; ready is true if its first
+ *                            task is COOK, false if it goes to PREP first
+ *   Ready(d, i, c)         - dish i is back from PREP, in line for a stove
+ *   Leave(d, i)            - dish i goes off to PREP
+ *   Done(d, i)             - dish i is done
+ *   Boost(d, c)            - time for a priority boost; returns true if
+ *                            the policy did anything
+ *   Pick(d, onStove, c, quantum, busy)
+ *                          - returns the dish to cook next on a stove
+ *                            (-1 for none) and sets its time quantum;
+ *                            busy(k) is true if dish k is on another stove
+ *   Sibling(d, k, match)   - returns a dish in line just as far up as
+ *                            dish k for which match(j) is true (-1 if
+ *                            none)
+ *   Levels(c)              - number of lines (queue levels)
+ *   Length(level)          - number of dishes in line at a level
+ *   Snap(s)                - save or restore the policy's own state
+ *                            (see snapshot.cpp)
+ *   Print(d, out)          - dump the lines (for debugging)
+ */
+
+/*
+ * MlfqPolicy - multilevel feedback queues: demote the dish on the stove
+ *              whenever the stove is rescheduled, promote dishes coming
+ *              back from PREP, boost everyone to the top every so often.
+ */
+class MlfqPolicy
+{
+public:
+    void Arrive(DishTable &d, int i, bool ready, SchedulerConfig &c)
+    {
+        // Initial queue is equal to priority (or the top queue, if there
+        //  are fewer queues than priorities)
+        int level = min(d.at(i).GetPriority(), c.GetQueueCount()) - 1;
+        if (ready)
+        {
+            _queues.Enqueue(d, i, level);
+        }
+        else
+        {
+            _queues.Park(d, i, level);
+        }
+    }
+    void Ready(DishTable &d, int i, SchedulerConfig &c)
+    {
+        // Equivalent of IO Blocking
+        //   'Promote' Dish/Process one level higher
+        int y = _queues.GetLevel(d, i);
+        // Push into one level higher
+        int top = c.GetQueueCount() - 1;
+        int higher = (y == top) ? top : y + 1;
+        _queues.Enqueue(d, i, higher);
+        d.at(i).SetPriority(higher + 1);
+
+        #ifdef DEBUG
+        cout << endl << "$ Promote Dish " << i << " from level " << y << " to " << higher << endl;
+        #endif
+    }
+    void Leave(DishTable &d, int i)
+    {
+        // Off to the assistants, out of line for the stove
+        _queues.Unlink(d, i);
+    }
+    void Done(DishTable &d, int i)
+    {
+        _queues.Remove(d, i);
+    }
+    bool Boost(DishTable &d, SchedulerConfig &c)
+    {
+        _queues.Boost(d, c.GetQueueCount() - 1);
+        return true;
+    }
+    template <class Busy>
+    int Pick(DishTable &d, int onStove, SchedulerConfig &c, int &quantum, Busy busy)
+    {
+        /*** Preemption Operations ***/
+        if (onStove > -1)
+        {
+            // Preemption must occur
+            // Demote currently cooking dish to lower queue
+            DishRef x = d.at(onStove);
+            // A dish that is no longer queued counts as coming from above the top
+            int y = _queues.GetLevel(d, onStove);
+            y = (y > -1) ? y : c.GetQueueCount();
+            int lower = (y == 0) ? 0 : y - 1;
+            if (x.GetState() == READY || x.GetState() == ONSTOVE)
+            {
+                _queues.Enqueue(d, onStove, lower);
+            }
+            else
+            {
+                _queues.Park(d, onStove, lower);
+            }
+            x.SetPriority(lower + 1);
+
+            #ifdef DEBUG
+            cout << "$ Demote Dish " << onStove << " from level " << y << " to " << lower << endl;
+            #endif
+        }
+
+        /*** Select a task from queue ***/
+
+        // Round Robin for priority level 0
+        //  This is ensured because once a Dish/Process has been demoted
+        //  to level 0, it can no longer be demoted further
+        // FCFS for priority levels 1 and up
+        //  Dishes already on another stove are passed over
+        int k = -1;
+        int chosenOne = _queues.TopLevel(); // Bias for higher priority
+        for (; chosenOne > -1; chosenOne = _queues.LevelBelow(chosenOne))
+        {
+            for (k = _queues.Front(chosenOne); k > -1 && busy(k); )
+            {
+                k = _queues.Next(d, k);
+            }
+            if (k > -1)
+            {
+                break;
+            }
+        }
+        if (chosenOne == -1)
+        {
+            chosenOne = c.GetQueueCount() - 1; // Nothing to cook
+        }
+
+        // Set time quantum
+        // -- Lower priority level queues => higher quantum
+        //     because they are less likely to be selected.
+        quantum = c.GetQuantum(chosenOne);
+
+        #ifdef DEBUG
+        cout << "  CHOOSE:  " << k << "  C: " << chosenOne << "  Q:  " << quantum << endl;
+        #endif
+
+        return k;
+    }
+    template <class Match>
+    int Sibling(DishTable &d, int k, Match match)
+    {
+        // Same queue level
+        for (int j = _queues.Front(_queues.GetLevel(d, k)); j > -1; j = _queues.Next(d, j))
+        {
+            if (match(j))
+            {
+                return j;
+            }
+        }
+        return -1;
+    }
+    int Levels(SchedulerConfig &c)
+    {
+        return c.GetQueueCount();
+    }
+    int Length(int level)
+    {
+        return _queues.GetLength(level);
+    }
+    void Snap(Snapshot &s)
+    {
+        _queues.Snap(s);
+    }
+    void Print(DishTable &d, ostream &out)
+    {
+        _queues.Print(d, out);
+    }
+private:
+    FeedbackQueues _queues; // one queue per priority level
+};
+
+/*
+ * KeyedPolicy - one line for the stoves, ordered by a key from Rule.
+ *
+ * Rule supplies Key(d, i, stamp), smallest first (stamp counts up each
+ * time a dish gets in line), and Quantum(d, k, c). The dish on a stove is
+ * put back in line with a fresh key whenever its stove is rescheduled, and
+ * wins ties, so that a stove does not switch dishes for nothing. Other
+ * ties go in tasklist order.
+ */
+template <class Rule>
+class KeyedPolicy
+{
+public:
+    typedef tuple<long long, int, int> Place; // (key, number of order, handle) of a dish in line
+
+    KeyedPolicy()
+    {
+        _stamp = 0;
+    }
+    void Arrive(DishTable &d, int i, bool ready, SchedulerConfig &/*c*/)
+    {
+        if (ready)
+        {
+            Insert(d, i);
+        }
+    }
+    void Ready(DishTable &d, int i, SchedulerConfig &/*c*/)
+    {
+        Insert(d, i);
+    }
+    void Leave(DishTable &d, int i)
+    {
+        Erase(d, i);
+    }
+    void Done(DishTable &d, int i)
+    {
+        Erase(d, i);
+    }
+    bool Boost(DishTable &/*d*/, SchedulerConfig &/*c*/)
+    {
+        return false; // Only the feedback queues have levels to boost
+    }
+    template <class Busy>
+    int Pick(DishTable &d, int onStove, SchedulerConfig &c, int &quantum, Busy busy)
+    {
+        bool inLine = onStove > -1 && InLine(d, onStove);
+        if (inLine)
+        {
+            Erase(d, onStove);
+            Insert(d, onStove);
+        }
+        int k = -1;
+        for (typename PooledSet<Place>::iterator it = _line.begin(); it != _line.end() && k == -1; ++it)
+        {
+            if (!busy(get<2>(*it)))
+            {
+                k = get<2>(*it);
+            }
+        }
+        if (k > -1 && inLine && d.LineKey(k) == d.LineKey(onStove))
+        {
+            k = onStove;
+        }
+        quantum = (k > -1) ? _rule.Quantum(d, k, c) : 1;
+        return k;
+    }
+    template <class Match>
+    int Sibling(DishTable &d, int k, Match match)
+    {
+        // Same key
+        long long key = d.LineKey(k);
+        typename PooledSet<Place>::iterator it = _line.lower_bound(Place(key, INT_MIN, INT_MIN));
+        for (; it != _line.end() && get<0>(*it) == key; ++it)
+        {
+            if (match(get<2>(*it)))
+            {
+                return get<2>(*it);
+            }
+        }
+        return -1;
+    }
+    int Levels(SchedulerConfig &/*c*/)
+    {
+        return 1; // One line
+    }
+    int Length(int /*level*/)
+    {
+        return _line.size();
+    }
+    void Snap(Snapshot &s)
+    {
+        // Keys, numbers and handles apart (tuples are not plain values)
+        vector<long long> keys;
+        vector<int> orders;
+        vector<int> dishes;
+        for (typename PooledSet<Place>::iterator it = _line.begin(); it != _line.end(); ++it)
+        {
+            keys.push_back(get<0>(*it));
+            orders.push_back(get<1>(*it));
+            dishes.push_back(get<2>(*it));
+        }
+        s.Field(keys);
+        s.Field(orders);
+        s.Field(dishes);
+        s.Field(_stamp);
+        _line.clear();
+        for (int j = 0; j < keys.size() && j < orders.size() && j < dishes.size(); j++)
+        {
+            _line.insert(Place(keys[j], orders[j], dishes[j]));
+        }
+    }
+    void Print(DishTable &d, ostream &out)
+    {
+        for (typename PooledSet<Place>::iterator it = _line.begin(); it != _line.end(); ++it)
+        {
+            out << get<2>(*it) << ", ";
+        }
+    }
+private:
+    bool InLine(DishTable &d, int i)
+    {
+        return d.LineKey(i) != LLONG_MIN;
+    }
+    void Insert(DishTable &d, int i)
+    {
+        d.LineKey(i) = _rule.Key(d, i, _stamp++);
+        _line.insert(Place(d.LineKey(i), d.at(i).GetOrder(), i));
+    }
+    void Erase(DishTable &d, int i)
+    {
+        if (InLine(d, i))
+        {
+            _line.erase(Place(d.LineKey(i), d.at(i).GetOrder(), i));
+            d.LineKey(i) = LLONG_MIN;
+        }
+    }
+    Rule _rule;
+    PooledSet<Place> _line; // dishes in line
+    long long _stamp; // times a dish got in line so far
+};
+
+// First come first served: by arrival, never preempted
+class FcfsRule
+{
+public:
+    long long Key(DishTable &d, int i, long long /*stamp*/)
+    {
+        return d.at(i).GetArrival();
+    }
+    int Quantum(DishTable &/*d*/, int /*k*/, SchedulerConfig &/*c*/)
+    {
+        return QUANTUM_NONE;
+    }
+};
+
+// Shortest job first: by time left in the current COOK task; preemptive
+//  (shortest remaining time first) re-decides every "second"
+template <bool Preemptive>
+class ShortestRule
+{
+public:
+    long long Key(DishTable &d, int i, long long /*stamp*/)
+    {
+        return d.at(i).GetNextTask()->GetTime();
+    }
+    int Quantum(DishTable &/*d*/, int /*k*/, SchedulerConfig &/*c*/)
+    {
+        return Preemptive ? 1 : QUANTUM_NONE;
+    }
+};
+
+// Priority round robin: highest priority first, round robin within a
+//  priority with the quantum of that priority's queue level
+class PriorityRule
+{
+public:
+    long long Key(DishTable &d, int i, long long stamp)
+    {
+        return ((long long)(MAX_PRIORITY - d.at(i).GetPriority()) << 40) + stamp;
+    }
+    int Quantum(DishTable &d, int k, SchedulerConfig &c)
+    {
+        return c.GetQuantum(min(d.at(k).GetPriority(), c.GetQueueCount()) - 1);
+    }
+};
+
+// Earliest deadline first, re-decided every "second". Tasklists have no
+//  deadlines, so a dish is due when it could be done at the earliest:
+//  arrival time plus the time of all steps of its recipe.
+class DeadlineRule
+{
+public:
+    long long Key(DishTable &d, int i, long long /*stamp*/)
+    {
+        return (long long)d.at(i).GetArrival() + d.at(i).GetRecipe()->GetTotalTime();
+    }
+    int Quantum(DishTable &/*d*/, int /*k*/, SchedulerConfig &/*c*/)
+    {
+        return 1;
+    }
+};
+
+typedef KeyedPolicy<FcfsRule> FcfsPolicy;
+typedef KeyedPolicy<ShortestRule<false> > SjfPolicy;
+typedef KeyedPolicy<ShortestRule<true> > SrtfPolicy;
+typedef KeyedPolicy<PriorityRule> PriorityPolicy;
+typedef KeyedPolicy<DeadlineRule> EdfPolicy;
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+#include "dish.cpp"
+#include "mfq.cpp"
+#include "textfile.cpp"
+
+#define RECIPEDIR "recipes/"
+
+using namespace std;
+
+void fatal_err(const string &s, int code);
+
+/*
+ * RecipeBook - every recipe parsed so far, by dish name.
+ *
+ * Each recipe file is read only once, however many dishes use it, and
+ * dishes point into the book instead of keeping their own copy. The steps
+ * of all recipes are kept together in one arena, and each name is stored
+ * once, as the key of its recipe. Once sealed, the book is read-only and
+ * can be shared between threads.
+ */
+class RecipeBook
+{
+public:
+    RecipeBook()
+    {
+        _sealed = false;
+    }
+    Recipe& Get(string_view name) // recipe for dish 'name', read from file if not yet known
+    {
+        string error;
+        Recipe *r = Find(name, error);
+        if (r == NULL)
+        {
+            if (error.empty())
+            {
+                string recipeFilename = RECIPEDIR + string(name) + ".txt";
+                fatal_err("Recipe file '" + recipeFilename + "' not found.", 4);
+            }
+            fatal_err(error, 5);
+        }
+        return *r;
+    }
+    /* Find() - like Get(), but does not stop the program
+     *        - returns NULL if there is no such recipe file (error is
+     *          empty) or it is corrupted (error says where)
+     */
+    Recipe * Find(string_view name, string &error)
+    {
+        error.clear();
+        // Lookup by string_view, so a known name costs no allocation
+        map<string, Recipe, less<> >::iterator it = _recipes.find(name);
+        if (it != _recipes.end())
+        {
+            return &it->second;
+        }
+        if (_sealed)
+        {
+            map<string, string, less<> >::iterator bad = _errors.find(name);
+            if (bad != _errors.end())
+            {
+                error = bad->second;
+            }
+            return NULL;
+        }
+        string key(name);
+        it = _recipes.emplace(key, Recipe(_steps)).first;
+        it->second.SetName(it->first);
+        size_t steps = _steps.size();
+        if (!Load(it->second, error))
+        {
+            // Take back what was read of it; it may be fixed and read again
+            _steps.resize(steps);
+            _recipes.erase(it);
+            if (!error.empty())
+            {
+                _errors[key] = error;
+            }
+            return NULL;
+        }
+        _errors.erase(key);
+        return &it->second;
+    }
+    void LoadAll() // read every recipe file in the recipes directory
+    {
+        filesystem::directory_iterator it(RECIPEDIR), end;
+        for (; it != end; ++it)
+        {
+            if (it->path().extension() == ".txt")
+            {
+                // A corrupted one is only an error for the dishes that use
+                //  it; once sealed, Find() still says what is wrong with it
+                string error;
+                Find(it->path().stem().string(), error);
+            }
+        }
+    }
+    void Seal() // no more reading recipe files from here on
+    {
+        _sealed = true;
+    }
+private:
+    /* Load() - parses 'recipes/<name>.txt' into r
+     *        - returns true if successful, else false with what is wrong
+     *          in error (empty if there is no such file)
+     */
+    bool Load(Recipe &r, string &error)
+    {
+        string recipeFilename = RECIPEDIR + r.GetName() + ".txt";
+        MappedFile recipeFile(recipeFilename);
+        if (!recipeFile.IsOpen())
+        {
+            return false;
+        }
+        LineReader reader(recipeFile.GetText());
+        string_view recipeLine;
+        size_t y;
+        if (!reader.Next(recipeLine))
+        {
+            error = "Recipe file '" + recipeFilename + "' is corrupted at line 1, column 1. Dish priority is missing.";
+            return false;
+        }
+        // Parse by finding the space
+        y = recipeLine.find(' ');
+        if (y == string_view::npos)
+        {
+            // space not found, trigger error
+            error = "Recipe file '" + recipeFilename + "' is corrupted at " + reader.Where(recipeLine.size() + 1) + ". Dish priority is missing.";
+            return false;
+        }
+        // The priority is the number after the space, then how arrivals
+        //  vary, if given (Monte Carlo mode)
+        int p = 0;
+        y++;
+        size_t z = y;
+        string_view spec = SplitSpread(recipeLine, z);
+        // Check if priority is valid
+        //  (priorities above the configured queue count start in the top queue)
+        if (!LineReader::ParseInt(recipeLine, y, p) || p < 1 || p > MAX_PRIORITY)
+        {
+            error = "Recipe file '" + recipeFilename + "' is corrupted at " + reader.Where(y) + ". Invalid dish priority (must be 1 to " + to_string(MAX_PRIORITY) + ").";
+            return false;
+        }
+        r.SetPriority(p);
+        if (!r.GetJitter().Parse(spec))
+        {
+            error = "Recipe file '" + recipeFilename + "' is corrupted at " + reader.Where(z) + ". Invalid arrival distribution.";
+            return false;
+        }
+        while (reader.Next(recipeLine))
+        {
+            // Parse by finding the space
+            y = recipeLine.find(' ');
+            if (y == string_view::npos)
+            {
+                // space not found, trigger error
+                error = "Recipe file '" + recipeFilename + "' is corrupted at " + reader.Where(recipeLine.size() + 1) + ". Space delimiter missing.";
+                return false;
+            }
+            // Step description is before the space
+            int ty = (recipeLine.substr(0, y) == "cook") ? COOK : PREP;
+            // Step time is the number after the space, then how it varies,
+            //  if given (Monte Carlo mode)
+            int ti = 0;
+            y++;
+            size_t z = y;
+            string_view spec = SplitSpread(recipeLine, z);
+            if (!LineReader::ParseInt(recipeLine, y, ti) || ti < 0)
+            {
+                error = "Recipe file '" + recipeFilename + "' is corrupted at " + reader.Where(y) + ". Invalid step time.";
+                return false;
+            }
+            Spread spread;
+            if (!spread.Parse(spec))
+            {
+                error = "Recipe file '" + recipeFilename + "' is corrupted at " + reader.Where(z) + ". Invalid time distribution.";
+                return false;
+            }
+            r.AddStep(Task(ty, ti), spread); // Push into the arena
+        }
+        // A dish needs at least one step to go through the kitchen
+        if (r.GetStepCount() == 0)
+        {
+            error = "Recipe file '" + recipeFilename + "' is corrupted at line " + to_string(reader.GetRow() + 1) + ". Recipe has no steps.";
+            return false;
+        }
+        return true;
+    }
+    /* SplitSpread() - cuts line after the number starting at (or after
+     *                 spaces from) x, e.g. "cook 30 normal 5" to "cook 30"
+     *               - returns the rest ("normal 5"), with x at its column
+     *                 (from 1)
+     */
+    static string_view SplitSpread(string_view &line, size_t &x)
+    {
+        size_t end = line.find_first_not_of(' ', x);
+        end = (end == string_view::npos) ? line.size() : min(line.find_first_of(" \t", end), line.size());
+        size_t start = line.find_first_not_of(" \t", end);
+        if (start == string_view::npos)
+        {
+            x = line.size() + 1;
+            return string_view();
+        }
+        string_view rest = line.substr(start);
+        line = line.substr(0, end);
+        x = start + 1;
+        return rest;
+    }
+    map<string, Recipe, less<> > _recipes;
+    vector<Task> _steps; // steps of every recipe, recipe by recipe
+    map<string, string, less<> > _errors; // what is wrong with recipe files that could not be read
+    bool _sealed;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include "snapshot.cpp"
+
+using namespace std;
+
+class RowWriter
+{
+public:
+    /*
+     * Constructor
+     */
+    RowWriter(ostream &out, bool collapse, bool wanted = true) : _out(out)
+    {
+        _wanted = wanted; // false if rows are to be thrown away
+        _collapse = collapse; // merge consecutive identical rows into one
+        _from = -1; // no pending row yet
+        _to = -1;
+    }
+
+    bool Wants() // returns true if rows are written anywhere
+    {
+        return _wanted;
+    }
+    void Row(int time, const string &body) // write the row for one "second"
+    {
+        Range(time, time, body);
+    }
+    void Range(int from, int to, const string &body) // write a row covering [from, to]
+    {
+        if (_collapse)
+        {
+            // Extend the pending row if this one is identical and contiguous
+            if (_from > -1 && _to + 1 == from && body == _body)
+            {
+                _to = to;
+                return;
+            }
+            Flush();
+            _from = from;
+            _to = to;
+            _body = body;
+            return;
+        }
+        Write(from, to, body);
+    }
+    void Splice(const string &rows) // add rows written by another RowWriter that collapses the same way
+    {
+        if (!_collapse)
+        {
+            if (_wanted)
+            {
+                _out << rows;
+            }
+            return;
+        }
+        // Row by row, so the first one can merge with the pending row
+        for (size_t at = 0; at < rows.size(); )
+        {
+            size_t end = rows.find('\n', at);
+            end = (end == string::npos) ? rows.size() : end;
+            size_t comma = rows.find(", ", at);
+            size_t dash = rows.find('-', at);
+            int from = atoi(rows.c_str() + at);
+            int to = (dash < comma) ? atoi(rows.c_str() + dash + 1) : from;
+            Range(from, to, rows.substr(comma + 2, end - comma - 2));
+            at = end + 1;
+        }
+    }
+    void Flush() // write out the pending collapsed row, if any
+    {
+        if (_from > -1)
+        {
+            Write(_from, _to, _body);
+            _from = -1;
+        }
+    }
+    void Snap(Snapshot &s) // save or restore the pending collapsed row
+    {
+        s.Field(_from);
+        s.Field(_to);
+        s.Field(_body);
+    }
+private:
+    void Write(int from, int to, const string &body)
+    {
+        if (!_wanted)
+        {
+            return;
+        }
+        _out << from;
+        if (to != from)
+        {
+            _out << "-" << to;
+        }
+        _out << ", " << body << endl;
+    }
+    ostream &_out;
+    bool _wanted;
+    bool _collapse;
+    int _from; // first "second" of pending row
+    int _to; // last "second" of pending row
+    string _body; // pending row minus the time column
+};
@@ -14,109 +14,459 @@ using namespace std;
 #define INPUTFILE "tasklist.txt"
 #define OUTPUTFILE "output.csv"
 #define PERFLOGFILE "perf.log"
-#define STOVE_DIRTY 0
-#define STOVE_CLEAN 2
-#define QUEUE_COUNT 10
-#define BOOST_QUANTUM 120 // Time interval for priority boost
+#define BATCHFILE "batch-summary.csv"
+#define SNAPSHOTFILE "checkpoint.snap"
+#define MONTECARLOFILE "montecarlo.csv"
 
 //#define DEBUG
 
+template <class Policy> class BasicScheduler;
+typedef BasicScheduler<MlfqPolicy> Scheduler;
+
 void fatal_err(const string &s, int code);
+void load_tasklist(const string &filename, RecipeBook &book, vector<Order> &orders);
+int read_tasklist(const string &filename, RecipeBook &book, vector<Order> &orders, string &error);
+void run_batch(const string &source, RecipeBook &book, Scheduler &proto, int threads);
+void run_tuner(Scheduler &proto, int threads);
+void run_montecarlo(Scheduler &proto, int runs, unsigned long long seed, Spread &jitter, int threads);
+vector<int> parse_list(const string &s);
+
+// Orders indices of orders (in a tasklist) by arrival time
+template <class Dishes>
+class ArrivesBefore
+{
+public:
+    ArrivesBefore(Dishes &d) : _d(d) { }
+    bool operator () (int a, int b)
+    {
+        return _d.at(a).GetArrival() < _d.at(b).GetArrival();
+    }
+private:
+    Dishes &_d;
+};
 
-class Scheduler
+/*
+ * BasicScheduler - the kitchen simulation, with the scheduling policy as a
+ *                  template argument so that its calls are inlined.
+ *
+ * Scheduler is the default MLFQ build; PolicyRegistry runs any other
+ * policy by name.
+ */
+template <class Policy>
+class BasicScheduler
 {
 public:
     /*
      * Constructors
      */
-    Scheduler()
+    BasicScheduler()
     {
-        _onStove = -1; // Nothing is on the stove
+        _stoves.resize(1); // One stove, nothing on it
+        _assistants = 0; // As many assistants as there are dishes to prep
         _time = 0; // Begin at 0 "seconds"/_time units
-        _stoveUtil = 0;
-        _stoveStatus = STOVE_CLEAN - 1;
-        for (int i = 0; i < QUEUE_COUNT; i++)
+        _eventDriven = false; // Step one "second" at a time by default
+        _collapse = false; // One output row per "second" by default
+        _switchAware = false; // Dispatch without regard to cleaning time by default
+        _nextArrival = 0;
+        _nextIncoming = 0;
+        _ordered = 0;
+        _active = 0;
+        _boosts = 0;
+        _outputFile = OUTPUTFILE;
+        _perfLogFile = PERFLOGFILE;
+        _trace = NULL;
+        _dishLog = NULL;
+        _feed = NULL; // Offline: every dish is known up front
+        _speed = 0;
+        _horizon = 0;
+        _retiredWeight = 0;
+        _retiredPriority = 0;
+        _checkpoint = 0; // No snapshots by default
+        _checkpointDue = 0;
+        _parallel = 0; // One stretch from start to end by default
+        _stop = 0;
+    }
+    BasicScheduler(vector<Order> &&d)
+    {
+        _orders = move(d); // Take over the orders of d instead of copying them
+        _stoves.resize(1); // One stove, nothing on it
+        _assistants = 0; // As many assistants as there are dishes to prep
+        _time = 0; // Begin at 0 "seconds"/_time units
+        _eventDriven = false; // Step one "second" at a time by default
+        _collapse = false; // One output row per "second" by default
+        _switchAware = false; // Dispatch without regard to cleaning time by default
+        _nextArrival = 0;
+        _nextIncoming = 0;
+        _ordered = 0;
+        _active = 0;
+        _boosts = 0;
+        _outputFile = OUTPUTFILE;
+        _perfLogFile = PERFLOGFILE;
+        _trace = NULL;
+        _dishLog = NULL;
+        _feed = NULL; // Offline: every dish is known up front
+        _speed = 0;
+        _horizon = 0;
+        _retiredWeight = 0;
+        _retiredPriority = 0;
+        _checkpoint = 0; // No snapshots by default
+        _checkpointDue = 0;
+        _parallel = 0; // One stretch from start to end by default
+        _stop = 0;
+    }
+
+    vector<Order>& GetOrders() // getter for orders of the tasklist (reference)
+    {
+        return _orders;
+    }
+    int GetOnStove(int s = 0) // getter for handle of dish on stove s (-1 if none)
+    {
+        return _stoves.at(s).GetDish();
+    }
+    int GetTime() // getter for time
+    {
+        return _time;
+    }
+    int GetStoves() // getter for number of stoves
+    {
+        return _stoves.size();
+    }
+    void SetStoves(int n) // setter for number of stoves (before Sim() only)
+    {
+        _stoves.assign(n, Stove());
+    }
+    void SetAssistants(int n) // setter for number of assistants, 0 for no limit (before Sim() only)
+    {
+        _assistants = n;
+        _prepSlots.assign(n, -1);
+        _prepUtil.assign(n, 0);
+    }
+    SchedulerConfig& GetConfig() // getter for scheduling parameters (reference)
+    {
+        return _config;
+    }
+    void SetConfig(const SchedulerConfig &c) // setter for scheduling parameters (before Sim() only)
+    {
+        _config = c;
+    }
+    void SetEventDriven(bool e) // setter for event-driven mode
+    {
+        _eventDriven = e;
+    }
+    bool IsEventDriven() // getter for event-driven mode
+    {
+        return _eventDriven;
+    }
+    void SetFeed(OrderFeed *feed, double speed) // setter for online mode: orders come from feed
+    {
+        // speed is simulated "seconds" per wall-clock second; 0 replays
+        //  the orders as fast as they can be read
+        _feed = feed;
+        _speed = speed;
+    }
+    void SetSwitchAware(bool a) // setter for switch-aware dispatch
+    {
+        _switchAware = a;
+    }
+    void SetStats(bool on, const string &file = "") // setter for hot-path counters, and JSON file for them ("" for perf.log only)
+    {
+        _stats.SetOn(on);
+        _statsFile = file;
+    }
+    void SetDishLog(const string &file) // setter for file with the times of every dish ("" for none)
+    {
+        _dishLogFile = file;
+    }
+    string GetDishLog() // getter for file with the times of every dish
+    {
+        return _dishLogFile;
+    }
+    DishMetrics& GetMetrics() // getter for turnaround, response and waiting times (reference)
+    {
+        return _metrics;
+    }
+    void SetCheckpoint(int every, const string &file) // setter for "seconds" between snapshots (0 for none) and their file
+    {
+        // "{t}" in the file name stands for the time of the snapshot
+        _checkpoint = every;
+        _checkpointFile = file;
+    }
+    void SetResume(const string &file) // setter for snapshot to go on from ("" to start at 0)
+    {
+        _resumeFile = file;
+    }
+    void SetParallel(int threads) // setter for threads simulating stretches between idle spells at once (0 for none)
+    {
+        _parallel = threads;
+    }
+    string GetStatsFile() // getter for JSON file of hot-path counters
+    {
+        return _statsFile;
+    }
+    void SetCollapse(bool c) // setter for collapsing identical output rows
+    {
+        _collapse = c;
+    }
+    void SetOutputFiles(const string &output, const string &perfLog, const string &trace = "") // setter for names of output, log and trace files
+    {
+        _outputFile = output;
+        _perfLogFile = perfLog;
+        _traceFile = trace;
+    }
+    template <class Other>
+    void MoveFrom(BasicScheduler<Other> &o) // take over dishes, settings and results of a scheduler with another policy (o is left without its dishes)
+    {
+        _orders = move(o._orders);
+        _dishes = move(o._dishes);
+        _time = o._time;
+        _stoves = move(o._stoves);
+        _assistants = o._assistants;
+        _prepSlots = move(o._prepSlots);
+        _prepUtil = move(o._prepUtil);
+        _config = o._config;
+        _boosts = o._boosts;
+        _eventDriven = o._eventDriven;
+        _collapse = o._collapse;
+        _switchAware = o._switchAware;
+        _outputFile = o._outputFile;
+        _perfLogFile = o._perfLogFile;
+        _traceFile = o._traceFile;
+        _feed = o._feed;
+        _speed = o._speed;
+        _retiredWeight = o._retiredWeight;
+        _retiredPriority = o._retiredPriority;
+        _stats = move(o._stats);
+        _statsFile = o._statsFile;
+        _metrics = move(o._metrics);
+        _dishLogFile = o._dishLogFile;
+        _checkpoint = o._checkpoint;
+        _checkpointFile = o._checkpointFile;
+        _resumeFile = o._resumeFile;
+        _parallel = o._parallel;
+    }
+    int GetStoveUtil() // getter for utilization time of all stoves
+    {
+        int stoveUtil = 0;
+        for (int s = 0; s < _stoves.size(); s++)
         {
-            vector<int> q;
-            _mfqs[i] = q;
+            stoveUtil += _stoves[s].GetUtil();
         }
-        _chosenOne = 9; // Choose highest priority queue by default
-        _quantum = 1; // By default, interrupt every 1 "second"
+        return stoveUtil;
     }
-    Scheduler(const vector<Dish> &d)
+    int GetStoveSwitches() // getter for times any stove was cleaned for another dish
     {
-        for (int i = 0; i < d.size(); i++)
+        int switches = 0;
+        for (int s = 0; s < _stoves.size(); s++)
         {
-            _dishes.push_back(d.at(i)); // Copy d into _dishes
+            switches += _stoves[s].GetSwitches();
         }
-        for (int i = 0; i < QUEUE_COUNT; i++)
+        return switches;
+    }
+    int GetStoveLost() // getter for "seconds" all stoves spent cleaning and preheating
+    {
+        int lost = 0;
+        for (int s = 0; s < _stoves.size(); s++)
         {
-            vector<int> q;
-            _mfqs[i] = q;
+            lost += _stoves[s].GetLost();
         }
-        cout << _mfqs[10].size() << endl;
-        _onStove = -1; // Nothing is on the stove
-        _time = 0; // Begin at 0 "seconds"/_time units
-        _stoveUtil = 0;
-        _stoveStatus = STOVE_CLEAN - 1;
-        _chosenOne = 9; // Choose highest priority queue by default
-        _quantum = 1; // By default, interrupt every 1 "second"
+        return lost;
     }
-
-    vector<Dish>& GetDishes() // getter for Dishes not yet arrived (reference)
+    int GetStoveIdle() // getter for idle time of all stoves
     {
-        return _dishes;
+        return _time * _stoves.size() - GetStoveUtil();
     }
-    Dish * GetOnStove() // getter for dish on stove (reference)
+    float GetWeightedWait() // getter for weighted average waiting time
     {
-        return (_onStove > -1) ? &(_dishes.at(_onStove)) : NULL;
+        double w;
+        long totalP;
+        GetWaitSums(w, totalP);
+        float avg = w;
+        avg /= totalP;
+        return avg;
     }
-    int GetTime() // getter for time
+    void GetWaitSums(double &w, long &totalP) // getter for sums of priority * waiting time and of priority
     {
-        return _time;
+        // WEIGHT = PRIORITY * WAITING TIME
+        // (dishes that left the kitchen are already summed up; the sum is
+        //  whole numbers, so it does not depend on the order of adding)
+        w = _retiredWeight;
+        totalP = _retiredPriority;
+        for (int i = 0; i < _dishes.size(); i++)
+        {
+            if (!_dishes.IsReleased(i))
+            {
+                totalP += _dishes.at(i).GetInitPriority();
+                w += _dishes.at(i).GetInitPriority() * _dishes.at(i).GetWaitingTime();
+            }
+        }
     }
     void Sim() // Begin simulation
     {
-        int n = _dishes.size();
-        ofstream out(OUTPUTFILE, ofstream::out);
-        if (out.is_open())
+        int n = _orders.size();
+        // Go on from a snapshot, if wanted; it says how much of the output
+        //  files was written by then
+        Snapshot *resume = NULL;
+        long long outputAt = -1;
+        long long dishLogAt = -1;
+        if (!_resumeFile.empty())
+        {
+            resume = new Snapshot(_resumeFile, true);
+            if (!resume->IsGood())
+            {
+                fatal_err("Snapshot file '" + _resumeFile + "' could not be read.", 1);
+            }
+            Snap(*resume, n, outputAt, dishLogAt);
+        }
+        // Binary trace of transitions, if wanted
+        TraceWriter *trace = NULL;
+        if (!_traceFile.empty())
+        {
+            trace = new TraceWriter(_traceFile);
+            if (!trace->IsOpen())
+            {
+                fatal_err("Trace file could not be opened.", 6);
+            }
+            trace->Begin(_stoves.size(), _orders);
+            _trace = trace;
+        }
+        // Times of every dish, as they are done, if wanted
+        ofstream dishLog;
+        if (!_dishLogFile.empty())
+        {
+            bool more = reopen_at(dishLog, _dishLogFile, dishLogAt);
+            if (!dishLog.is_open())
+            {
+                fatal_err("Dish log file could not be opened.", 6);
+            }
+            if (!more)
+            {
+                dishLog << "Dish, Name, Initial Priority, Arrival, First On Stove, Done, Turnaround, Response, Waiting" << endl;
+            }
+            _dishLog = &dishLog;
+        }
+        // No output file name means simulate without writing the schedule,
+        //  "-" means write each row to stdout as soon as it is done
+        bool toStdout = (_outputFile == "-");
+        ofstream out;
+        bool more = false; // Going on with the output of an earlier run
+        if (!_outputFile.empty() && !toStdout)
         {
+            more = reopen_at(out, _outputFile, outputAt);
+        }
+        if (out.is_open() || _outputFile.empty() || toStdout)
+        {
+            // Rows are formatted here and written to the file on another thread
+            AsyncStreamBuf *async = out.is_open() ? new AsyncStreamBuf(out) : NULL;
+            ostream csv(toStdout ? cout.rdbuf() : async);
+            bool wanted = out.is_open() || toStdout;
+            RowWriter rows(csv, _collapse, wanted);
             // Print CSV headers
-            out << "Time, Stove, Ready, Assistants, Remarks" << endl;
-            while (n > 0)
+            if (wanted && !more)
+            {
+                csv << "Time, ";
+                for (int s = 0; s < _stoves.size(); s++)
+                {
+                    csv << StoveName(s) << ", ";
+                }
+                csv << "Ready, Assistants, Remarks" << endl;
+            }
+            if (resume != NULL)
+            {
+                rows.Snap(*resume);
+                if (!resume->IsGood())
+                {
+                    fatal_err("Snapshot file '" + _resumeFile + "' is corrupted.", 8);
+                }
+                delete resume;
+            }
+            else if (_parallel <= 1)
+            {
+                LineUp();
+            }
+            if (_parallel > 1)
             {
-                n = Proceed(n, out);
+                RunSplit(rows);
             }
+            else
+            {
+                long long outputBase = more ? outputAt : 0; // Bytes in the output file before this run
+                _checkpointDue = (_checkpoint > 0) ? (_time / _checkpoint + 1) * _checkpoint : 0;
+                n = Run(n, rows, async, outputBase);
+            }
+            rows.Flush();
             // Write last line of output file
-            out << ++_time << ", -- Idle --, , , Cleaning stove." << endl;
-            // Close file stream
-            out.close();
+            _time++;
+            if (_trace)
+            {
+                _trace->End(_time);
+                _trace = NULL;
+                delete trace;
+            }
+            if (wanted)
+            {
+                csv << _time << ", ";
+                string remarks;
+                for (int s = 0; s < _stoves.size(); s++)
+                {
+                    csv << "-- Idle --, ";
+                    remarks += (s == 0) ? "" : " ";
+                    remarks += "Cleaning " + Lower(StoveName(s)) + ".";
+                }
+                csv << ", , " << remarks << endl;
+                // Wait for the writer thread, then close file stream
+                if (async != NULL)
+                {
+                    async->Close();
+                    delete async;
+                    out.close();
+                }
+            }
+            _dishLog = NULL;
         }
         else
         {
             fatal_err("Output file could not be opened.", 6);
         }
         // Print out performance metric to log file
-        out.open(PERFLOGFILE, ofstream::out);
+        if (_perfLogFile.empty())
+        {
+            return;
+        }
+        out.open(_perfLogFile.c_str(), ofstream::out);
         if (out.is_open())
         {
             // Write log header
             out << "Scheduling Performance Log" << endl;
             // Write metrics
             out << "Total Simulated Time          : " << _time << endl;
-            out << "Stove Utilization Time        : " << _stoveUtil << endl;
-            out << "Stove Idle Time               : " << _time - _stoveUtil << endl;
+            out << "Stove Utilization Time        : " << GetStoveUtil() << endl;
+            out << "Stove Idle Time               : " << GetStoveIdle() << endl;
             // Get weighted average waiting time
-            // WEIGHT = PRIORITY * WAITING TIME
-            float w = 0.0;
-            int totalP = 0;
-            for (int i = 0; i < _dishes.size(); i++)
+            out << "Weighted Average Waiting Time : " << GetWeightedWait() << endl;
+            out << "Priority Boosts               : " << _boosts << endl;
+            out << "Stove Switches                : " << GetStoveSwitches() << endl;
+            out << "Time Lost to Switches         : " << GetStoveLost() << endl;
+            // Per resource metrics, if there is more than the one stove
+            if (_stoves.size() > 1)
+            {
+                for (int s = 0; s < _stoves.size(); s++)
+                {
+                    out << left << setw(30) << StoveName(s) + " Utilization Time" << ": " << _stoves[s].GetUtil() << endl;
+                    out << left << setw(30) << StoveName(s) + " Idle Time" << ": " << _time - _stoves[s].GetUtil() << endl;
+                }
+            }
+            for (int a = 0; a < _assistants; a++)
             {
-                totalP += _dishes.at(i).GetPriority();
-                w += _dishes.at(i).GetPriority() * _dishes.at(i).GetWaitingTime();
+                ostringstream name;
+                name << "Assistant " << a + 1;
+                out << left << setw(30) << name.str() + " Utilization Time" << ": " << _prepUtil[a] << endl;
+                out << left << setw(30) << name.str() + " Idle Time" << ": " << _time - _prepUtil[a] << endl;
+            }
+            _metrics.Write(out);
+            if (_stats.IsOn())
+            {
+                _stats.Write(out);
             }
-            w /= totalP;
-            out << "Weighted Average Waiting Time : " << w << endl;
             // Close file stream
             out.close();
         }
@@ -124,481 +474,1729 @@ public:
         {
             fatal_err("Performance log file could not be opened.\nThe simulation still went through, but metrics were not recorded.", 6);
         }
+        if (!_statsFile.empty())
+        {
+            ofstream json(_statsFile.c_str(), ofstream::out);
+            if (!json.is_open())
+            {
+                fatal_err("Stats file could not be opened.", 6);
+            }
+            _stats.WriteJson(json);
+        }
     }
 private:
-    /* Schedule() - selects the next dish to be cooked
-     *            - no arguments
-     *            - returns index (in _dishes) of dish to be cooked
+    template <class> friend class BasicScheduler;
+    friend class Bench;
+    /* LineUp() - lines up the dishes of the tasklist by arrival before the
+     *            first "second" (ties keep tasklist order)
      */
-    int Schedule()
+    void LineUp()
     {
-        /*** Preemption Operations ***/
-        if (_onStove > -1)
+        _arrivals.clear();
+        for (int i = 0; i < _orders.size(); i++)
         {
-            // Preemption must occur
-            // Demote currently cooking dish to lower queue
-
-            // Temporarily Remove from scheduling queue to move somewhere else
-            int y;
-            bool notDone = true;
-            for (y = 0; y < QUEUE_COUNT && notDone; y++)
-            {
-                for (int z = 0; z < _mfqs[y].size(); z++)
-                {
-                    if (_mfqs[y][z] == _onStove)
-                    {
-                        _mfqs[y].erase(_mfqs[y].begin() + z);
-                        notDone = false;
-                        y -= 1;
-                        break;
-                    }
-                }
-            }
-            int lower = (y == 0) ? 0 : y - 1;
-            _mfqs[lower].push_back(_onStove);
-            _dishes.at(_onStove).SetPriority(lower + 1);
-
-            #ifdef DEBUG
-            cout << "$ Demote Dish " << _onStove << " from level " << y << " to " << lower << endl;
-            #endif
+            _arrivals.push_back(i);
         }
-
-        int k = -1;
-        _chosenOne = 9; // Bias for higher priority
-        int cycleStart = _chosenOne;
-        // Look for the first nonempty queue, cycling downwards
-        do
+        stable_sort(_arrivals.begin(), _arrivals.end(), ArrivesBefore<vector<Order> >(_orders));
+        _nextArrival = 0;
+        if (_eventDriven)
         {
-            // If queue is empty, cycle downward to next queue
-            if ( _mfqs[_chosenOne].size() == 0 )
+            // Every arrival is known in advance
+            for (int i = 0; i < _orders.size(); i++)
             {
-                _chosenOne = (_chosenOne == 0) ? QUEUE_COUNT - 1 : _chosenOne - 1;
-                continue;
+                _events.push(SimEvent(_orders.at(i).GetArrival(), EV_ARRIVE, i));
             }
-
-            /*** Select a task from queue ***/
-
-            // Round Robin for priority level 0
-            //  This is ensured because once a Dish/Process has been demoted
-            //  to level 0, it can no longer be demoted further
-            // FCFS for priority levels 1 and up
-            int x = 0;
-            k = _mfqs[_chosenOne][x];
-            while( _dishes.at(k).GetState() != READY && _dishes.at(k).GetState() != ONSTOVE)
+            int boost = _config.GetBoost();
+            if (boost > 0)
             {
-
-                #ifdef DEBUG
-                cout << "  X: " << x << "  STATE:  " << _dishes.at(k).GetState() << "  ";
-                #endif
-
-                x++;
-                if (x > _mfqs[_chosenOne].size() - 1)
+                _events.push(SimEvent((_time / boost + 1) * boost, EV_BOOST, -1));
+            }
+            // A stretch of a split run must not skip past its end
+            if (_stop > 0)
+            {
+                _events.push(SimEvent(_stop + 1, EV_ARRIVE, -1));
+            }
+        }
+    }
+    /* Run() - simulates until every dish is done and no more orders can
+     *         come in; in a split run, until the clock is at _stop
+     *       - arguments are number of dishes not done, row writer, output
+     *         file buffer (NULL if none) & bytes in the output file before
+     *         this run (for snapshots)
+     *       - returns number of dishes not done
+     */
+    int Run(int n, RowWriter &rows, AsyncStreamBuf *async, long long outputBase)
+    {
+        // Online, orders keep coming in until the source closes
+        _start = chrono::steady_clock::now();
+        while ((_stop > 0) ? _time < _stop : (n > 0 || (_feed != NULL && _feed->IsOpen())))
+        {
+            if (_feed != NULL)
+            {
+                n += TakeOrders();
+                if (n == 0 && !_feed->IsOpen())
                 {
-                    k = -1;
                     break;
                 }
-                else
+            }
+            if (_eventDriven)
+            {
+                SkipQuiet(rows);
+                if (_stop > 0 && _time >= _stop)
                 {
-                    k = _mfqs[_chosenOne][x];
+                    break;
                 }
             }
-
-            #ifdef DEBUG
-            cout << "  K: " << k << "  ";
-            #endif
-
-            if (k > -1)
+            n = Proceed(n, rows);
+            Retire();
+            if (_checkpoint > 0 && _time >= _checkpointDue)
             {
-                break;
+                Checkpoint(n, rows, async, outputBase);
             }
-            _chosenOne = (_chosenOne == 0) ? QUEUE_COUNT - 1 : _chosenOne - 1;
-        }
-        while(_chosenOne != cycleStart);
-
-        // Set time quantum
-        // -- Lower priority level queues => higher quantum
-        //     because they are less likely to be selected.
-        switch(_chosenOne)
-        {
-            case 9:
-                _quantum = 2;
-            break;
-            case 8:
-                _quantum = 3;
-            break;
-            case 7:
-                _quantum = 4;
-            break;
-            case 6:
-                _quantum = 6;
-            break;
-            case 5:
-                _quantum = 7;
-            break;
-            case 4:
-                _quantum = 8;
-            break;
-            case 3:
-                _quantum = 10;
-            break;
-            case 2:
-                _quantum = 11;
-            break;
-            case 1:
-                _quantum = 12;
-            break;
-            default:
-                _quantum = 14;
         }
-
-        #ifdef DEBUG
-        cout << "  CHOOSE:  " << k;
-        cout << "  C: " << _chosenOne << "  CS: " << cycleStart;
-        cout << "  Q:  " << _quantum << endl;
-        #endif
-
-        // Next cycle should start with queue below this one
-        //_chosenOne = (_chosenOne == 0) ? QUEUE_COUNT - 1 : _chosenOne - 1;
-
-        return k;
+        return n;
     }
-    /* Proceed() - moves the simulation one step forward in time
-     *           - arguments are number of Dishes not done & output stream
-     *           - returns number of Dishes not done;
+    /*
+     * Stretch - part of a split run: a kitchen of its own for the orders
+     *           that arrive in one stretch of time, with its rows and dish
+     *           log kept in memory
      */
-    int Proceed(int n, ostream &out) // argument : output stream where output is to be printed
+    class Stretch
     {
-        string remarks; // Stores remarks string
-        _time++; // Time travel (1 second ahead)
-        _quantum--; // Go closer to next quantum
-
-        #ifdef DEBUG
-        cout << _time << "  ";
-        #endif
+    public:
+        Stretch(bool collapse, bool wanted) : rows(csv, collapse, wanted)
+        {
+            n = 0;
+        }
+        void Start() // simulate from an idle kitchen up to the end of the stretch
+        {
+            sim.LineUp();
+            n = sim.Run(sim._orders.size(), rows, NULL, 0);
+        }
+        BasicScheduler sim;
+        ostringstream csv; // rows, as RowWriter writes them
+        ostringstream dishLog;
+        RowWriter rows;
+        int n; // dishes not done at the end
+    };
+    /* RunSplit() - cuts the tasklist where the kitchen is likely to be idle,
+     *              simulates the stretches in between at once on _parallel
+     *              threads, then puts them together in order
+     *            - argument is the row writer for output
+     *
+     * Once every dish is done, the stoves are empty and half clean and only
+     * the boost is due, nothing before can change what comes after: each
+     * stretch starts from such a kitchen at the "second" before its first
+     * arrival. That is checked when it is put together with the stretch
+     * before; if the kitchen was not idle after all, the stretch before goes
+     * on with the orders of this one instead. Either way the rows and
+     * metrics are those of a run from start to end.
+     */
+    void RunSplit(RowWriter &rows)
+    {
+        vector<int> cuts = SplitPoints(4 * _parallel);
+        if (cuts.empty())
+        {
+            LineUp();
+            Run(_orders.size(), rows, NULL, 0);
+            return;
+        }
+        int m = cuts.size() + 1;
+        vector<Stretch *> parts;
+        for (int k = 0; k < m; k++)
+        {
+            parts.push_back(new Stretch(_collapse, rows.Wants()));
+            BasicScheduler &sim = parts[k]->sim;
+            sim.Configure(*this);
+            sim._time = (k > 0) ? cuts[k - 1] - 1 : 0;
+            sim._stop = (k < m - 1) ? cuts[k] - 1 : 0;
+            sim._dishLog = _dishLog ? &parts[k]->dishLog : NULL;
+        }
+        // Orders go to the stretch they arrive in, in tasklist order
+        for (int i = 0; i < _orders.size(); i++)
+        {
+            int k = upper_bound(cuts.begin(), cuts.end(), _orders[i].GetArrival()) - cuts.begin();
+            parts[k]->sim._orders.push_back(_orders[i]);
+            parts[k]->sim._orderIds.push_back(i);
+        }
+        TickKernels::Get(); // chosen once, before the threads start
+        WorkPool pool(_parallel);
+        pool.Run(m, [&](int k) { parts[k]->Start(); });
 
-        #ifdef DEBUG
-        for (int i = 0; i < QUEUE_COUNT; i++)
+        Stretch *cur = parts[0];
+        for (int k = 1; k < m; k++)
         {
-            cout << "Q" << i << ": ";
-            for (int j = 0; j < _mfqs[i].size(); j++)
+            if (cur->sim.IsIdle(cur->n))
+            {
+                Absorb(*cur, rows);
+                delete cur;
+                cur = parts[k];
+            }
+            else
             {
-                cout << _mfqs[i][j] << ", ";
+                // Guessed wrong: no idle spell here
+                int added = cur->sim.Extend(parts[k]->sim);
+                cur->n = cur->sim.Run(cur->n + added, cur->rows, NULL, 0);
+                delete parts[k];
             }
         }
-        cout << endl;
-        #endif
-
-        /**** Check if a dish is arriving ****/
-        for (int i = 0; i < _dishes.size(); i++)
+        Absorb(*cur, rows);
+        delete cur;
+    }
+    /* SplitPoints() - guesses where the kitchen will be idle, from how much
+     *                 cooking and prepping the orders bring in
+     *               - argument is about how many stretches are wanted
+     *               - returns arrival times to cut at, in order
+     */
+    vector<int> SplitPoints(int parts)
+    {
+        vector<int> byArrival;
+        for (int i = 0; i < _orders.size(); i++)
+        {
+            byArrival.push_back(i);
+        }
+        stable_sort(byArrival.begin(), byArrival.end(), ArrivesBefore<vector<Order> >(_orders));
+        vector<int> cuts;
+        int target = max(1, (int)_orders.size() / max(1, parts));
+        int since = 0; // orders since the last cut
+        // Stoves (and assistants, if limited) as one pool each that works
+        //  through its backlog; done = when the last dish could be done
+        double stovesFree = 0;
+        double prepFree = 0;
+        double done = 0;
+        for (int j = 0; j < byArrival.size(); j++)
         {
-            // A Dish has "arrived" if its arrival time is equal to current "time"
-            if (_dishes.at(i).GetArrival() == _time)
+            Order &o = _orders[byArrival[j]];
+            int at = o.GetArrival();
+            if (since >= target && at - 1 > done + STOVE_SWITCH && (cuts.empty() || at > cuts.back()))
             {
-                // Add to Remarks
-                remarks += _dishes.at(i).GetName() + " arrives. ";
-
-                Dish &d = _dishes.at(i); // get reference to target Dish
-
-                // Add Process Index to scheduling queue, initially equal to priority
-                _mfqs[d.GetPriority() - 1].push_back(i);
-
-                Task * t = d.GetNextTask();
-                // Change State of Dish so it is not passed over by
-                //  later instructions
-                if (t->GetType() == COOK)
-                {
-                    d.SetState(READY); // Ready for cooking
-                }
-                else
+                cuts.push_back(at);
+                since = 0;
+            }
+            Recipe *r = o.GetRecipe();
+            int cook = 0; // COOK time
+            int switches = 0; // cleaning and preheating before each COOK step
+            for (int k = 0; k < r->GetStepCount(); k++)
+            {
+                if (r->GetStep(k).GetType() == COOK)
                 {
-                    d.SetState(PREPPING); // Must be prepped
+                    cook += r->GetStep(k).GetTime();
+                    switches += STOVE_SWITCH;
                 }
             }
+            int prep = r->GetTotalTime() - cook;
+            stovesFree = max(stovesFree, (double)at) + (double)(cook + switches) / _stoves.size();
+            prepFree = (_assistants > 0) ? max(prepFree, (double)at) + (double)prep / _assistants : 0;
+            done = max(max(done, stovesFree), max(prepFree, (double)at + r->GetTotalTime()));
+            since++;
         }
-        /**** Select which one to cook next ****/
-
-        // TESTING >>=>> Use First Come First Serve
-        int k;
-        if (_quantum > 0 && _onStove > -1 && _onStove < _dishes.size() && _dishes.at(_onStove).GetState() == READY)
+        return cuts;
+    }
+    /* Configure() - split runs: takes the settings of o, but none of its
+     *               orders, dishes or files
+     */
+    void Configure(BasicScheduler &o)
+    {
+        _stoves.assign(o._stoves.size(), Stove());
+        SetAssistants(o._assistants);
+        _config = o._config;
+        _eventDriven = o._eventDriven;
+        _collapse = o._collapse;
+        _switchAware = o._switchAware;
+        _stats.SetOn(o._stats.IsOn());
+        _outputFile = "";
+        _perfLogFile = "";
+    }
+    /* IsIdle() - split runs: returns true if nothing so far can make a
+     *            difference from the next "second" on: every dish is done,
+     *            the stoves are empty and half clean (as they stay when
+     *            idle) and no event but the boost is due later
+     *          - argument is number of dishes not done
+     */
+    bool IsIdle(int n)
+    {
+        if (n > 0 || _active > 0 || !_prepLine.empty())
         {
-            k = _onStove;
+            return false;
         }
-        else
+        for (int s = 0; s < _stoves.size(); s++)
         {
-            k = Schedule();
+            if (_stoves[s].GetDish() > -1 || _stoves[s].GetStatus() != STOVE_CLEAN - 1)
+            {
+                return false;
+            }
         }
-
-        // if Stove is clean or dish isn't changed, proceed normally
-        if (k == _onStove || _stoveStatus == STOVE_CLEAN)
+        for (int a = 0; a < _assistants; a++)
         {
-            _onStove = k;
-            // The stove is "dirty" now iff. it is not empty
-            if (_onStove > -1) _stoveStatus = STOVE_DIRTY;
+            if (_prepSlots[a] > -1)
+            {
+                return false;
+            }
         }
-        // Stove is dirty and dish needs to be changed
-        else if (_stoveStatus == STOVE_DIRTY)
+        // Leftover events come at most with the next arrival
+        for (EventQueue q = _events; !q.empty(); q.pop())
         {
-            _onStove = -1;
-            remarks += "Cleaning stove. ";
-            _stoveStatus += 1; // 1 step towards a clean stove
+            if (q.top().GetTime() > _time + 1 && q.top().GetType() != EV_BOOST)
+            {
+                return false;
+            }
         }
-        // Dish needs to be changed and stove is almost clean
-        else
+        return true;
+    }
+    /* Extend() - split runs: takes on the orders of the stretch after this
+     *            one, which all arrive after the orders so far, and its end
+     *          - returns number of orders added
+     */
+    int Extend(BasicScheduler &next)
+    {
+        int first = _orders.size();
+        _orders.insert(_orders.end(), next._orders.begin(), next._orders.end());
+        _orderIds.insert(_orderIds.end(), next._orderIds.begin(), next._orderIds.end());
+        vector<int> later;
+        for (int i = first; i < _orders.size(); i++)
         {
-            _onStove = -1;
-            remarks += "Preheating stove. ";
-            _stoveStatus += 1; // Stove is clean next time
+            later.push_back(i);
+            Expect(_orders[i].GetArrival(), EV_ARRIVE, i);
         }
-
-        if (_onStove > -1)
+        stable_sort(later.begin(), later.end(), ArrivesBefore<vector<Order> >(_orders));
+        _arrivals.insert(_arrivals.end(), later.begin(), later.end());
+        _stop = next._stop;
+        if (_stop > 0)
         {
-            _dishes.at(_onStove).SetState(ONSTOVE);
+            Expect(_stop + 1, EV_ARRIVE, -1);
         }
-
-        /**** Cook ****/
-
-        // Print Time
-        out << _time << ", ";
-
-        // Print Dish on stove
-        if (_onStove > -1)
+        return _orders.size() - first;
+    }
+    /* Absorb() - split runs: adds the rows, dish log and metrics of a
+     *            finished stretch, the next one in time
+     *          - arguments are the stretch & row writer for output
+     */
+    void Absorb(Stretch &p, RowWriter &rows)
+    {
+        p.rows.Flush();
+        rows.Splice(p.csv.str());
+        if (_dishLog)
         {
-            out << _dishes.at(_onStove);
-            _stoveUtil += 1;
+            *_dishLog << p.dishLog.str();
         }
-        else
+        BasicScheduler &o = p.sim;
+        for (int s = 0; s < _stoves.size(); s++)
         {
-            out << "-- Idle --";
+            _stoves[s].Merge(o._stoves[s]);
         }
-        out << ", ";
-        // Print Ready
-        for (int i = 0; i < _dishes.size(); i++)
+        for (int a = 0; a < _assistants; a++)
         {
-            if (_dishes.at(i).GetState() == READY && _dishes.at(i).GetState() != ONSTOVE)
-            {
-                out << _dishes.at(i) << "   ";
-            }
+            _prepUtil[a] += o._prepUtil[a];
         }
-        out << ", ";
-        // Print Assistants/Prep
-        for (int i = 0; i < _dishes.size(); i++)
+        _boosts += o._boosts;
+        double w;
+        long totalP;
+        o.GetWaitSums(w, totalP);
+        _retiredWeight += w;
+        _retiredPriority += totalP;
+        _metrics.Merge(o._metrics);
+        _stats.Merge(o._stats);
+        _time = o._time;
+    }
+    /* Snap() - saves the state of the simulation to a snapshot, or
+     *          restores it from one
+     *        - arguments are the snapshot, number of dishes not done, and
+     *          bytes written to the output file and dish log by then (-1 if
+     *          there are none)
+     */
+    void Snap(Snapshot &s, int &n, long long &outputAt, long long &dishLogAt)
+    {
+        // What the state depends on must be the same as in this run;
+        //  the rest (quanta, boost, switch-aware) may change from here on
+        long long orders = _orders.size();
+        unsigned long long sum = OrdersSum();
+        int stoves = _stoves.size();
+        int assistants = _assistants;
+        int queues = _config.GetQueueCount();
+        string policy = _config.GetPolicy();
+        bool eventDriven = _eventDriven;
+        bool collapse = _collapse;
+        s.Field(orders);
+        s.Field(sum);
+        s.Field(stoves);
+        s.Field(assistants);
+        s.Field(queues);
+        s.Field(policy);
+        s.Field(eventDriven);
+        s.Field(collapse);
+        if (s.IsLoading() && s.IsGood())
         {
-            if (_dishes.at(i).GetState() == PREPPING)
+            string differs = (orders != _orders.size() || sum != OrdersSum()) ? "tasklist"
+                : (stoves != _stoves.size()) ? "number of stoves"
+                : (assistants != _assistants) ? "number of assistants"
+                : (queues != _config.GetQueueCount()) ? "number of queues"
+                : (policy != _config.GetPolicy()) ? "policy"
+                : (eventDriven != _eventDriven) ? "'--event' setting"
+                : (collapse != _collapse) ? "'--collapse' setting" : "";
+            if (!differs.empty())
             {
-                out << _dishes.at(i) << "   ";
+                fatal_err("Snapshot file '" + _resumeFile + "' was taken with another " + differs + ".", 8);
             }
         }
-        out << ", ";
-
-        for (int i = 0; i < _dishes.size(); i++)
+        s.Field(n);
+        s.Field(outputAt);
+        s.Field(dishLogAt);
+        s.Field(_time);
+        _dishes.Snap(s, _orders);
+        s.Field(_stoves);
+        s.Field(_prepSlots);
+        s.Field(_prepUtil);
+        s.Field(_prepLine);
+        _policy.Snap(s);
+        s.Field(_boosts);
+        s.Field(_active);
+        s.Field(_arrivals);
+        s.Field(_finished);
+        s.Field(_retiredWeight);
+        s.Field(_retiredPriority);
+        s.Field(_nextArrival);
+        // Upcoming events as (time, type, dish)
+        vector<int> events;
+        for (EventQueue q = _events; !q.empty(); q.pop())
+        {
+            events.push_back(q.top().GetTime());
+            events.push_back(q.top().GetType());
+            events.push_back(q.top().GetDish());
+        }
+        s.Field(events);
+        _metrics.Snap(s);
+        _stats.Snap(s);
+        if (s.IsLoading())
         {
-            if (_dishes.at(i).GetState() == NOTARRIVED || _dishes.at(i).GetState() == DONE)
+            _events = EventQueue();
+            for (int e = 0; e + 2 < events.size(); e += 3)
             {
-                continue;
+                _events.push(SimEvent(events[e], (event_type)events[e + 1], events[e + 2]));
             }
-
-            Task * t = _dishes.at(i).GetNextTask();
-            Task * prevT = t;
-
-            /*** Do Tasks ***/
-            dish_state dS = _dishes.at(i).GetState();
-            if (dS == ONSTOVE || dS == PREPPING)
+            // The boost interval may have changed
+            int boost = _config.GetBoost();
+            if (boost > 0)
             {
-                t->Step();
+                Expect((_time / boost + 1) * boost, EV_BOOST, -1);
             }
-            t = _dishes.at(i).GetNextTask();
-
-            // Set States based on next task
-            if (t == NULL)
+            // Life cycles are not stored; each dish picks up from its state
+            _lives.Clear();
+            for (int i = 0; i < _dishes.size(); i++)
             {
-                // No more tasks in recipe -- dish is done
-                remarks += _dishes.at(i).GetName() + " is Done. ";
-                // Set state to DONE, so it is ignored
-                _dishes.at(i).SetState(DONE);
-                n -= 1; // decrease number of dishes not done yet
-                // Remove from scheduling queue
-                bool notDone = true;
-                for (int y = 0; y < QUEUE_COUNT && notDone; y++)
+                if (_dishes.IsReleased(i))
                 {
-                    for (int z = 0; z < _mfqs[y].size(); z++)
-                    {
-                        if (_mfqs[y][z] == i)
-                        {
-                            _mfqs[y].erase(_mfqs[y].begin() + z);
-                            notDone = false;
-                            break;
-                        }
-                    }
+                    continue;
+                }
+                dish_state st = _dishes.at(i).GetState();
+                if (st != NOTARRIVED && st != DONE)
+                {
+                    _lives.Start(i, Life(i));
                 }
             }
-            else if (t->GetType() == COOK)
+        }
+    }
+    /* Checkpoint() - writes a snapshot of the simulation as of now
+     *              - arguments are number of dishes not done, row writer,
+     *                output file buffer (NULL if none) & bytes in the
+     *                output file before this run
+     */
+    void Checkpoint(int n, RowWriter &rows, AsyncStreamBuf *async, long long outputBase)
+    {
+        // Everything written so far must be in the files before the
+        //  snapshot says so
+        long long outputAt = -1;
+        if (async != NULL)
+        {
+            async->Drain();
+            outputAt = outputBase + async->pubseekoff(0, ios_base::cur, ios_base::out);
+        }
+        long long dishLogAt = -1;
+        if (_dishLog)
+        {
+            _dishLog->flush();
+            dishLogAt = _dishLog->tellp();
+        }
+        string file = _checkpointFile;
+        size_t at = file.find("{t}");
+        if (at != string::npos)
+        {
+            file.replace(at, 3, to_string(_time));
+        }
+        Snapshot s(file, false);
+        Snap(s, n, outputAt, dishLogAt);
+        rows.Snap(s);
+        if (!s.Close())
+        {
+            fatal_err("Snapshot file '" + file + "' could not be written.", 6);
+        }
+        _checkpointDue = (_time / _checkpoint + 1) * _checkpoint;
+    }
+    /* OrdersSum() - returns a checksum of the orders (dish names and
+     *               arrival times), to tell tasklists apart
+     */
+    unsigned long long OrdersSum()
+    {
+        // FNV-1a
+        unsigned long long h = 14695981039346656037ULL;
+        for (int i = 0; i < _orders.size(); i++)
+        {
+            const string &name = _orders[i].GetRecipe()->GetName();
+            for (int c = 0; c < name.size(); c++)
             {
-                _dishes.at(i).SetState(READY);
-                // In Ready queue, i.e. Dish is WAITING; increment waiting time
-                _dishes.at(i).Wait();
-                // Check if just finished from PREP stage
-                if (prevT->GetType() == PREP)
+                h = (h ^ (unsigned char)name[c]) * 1099511628211ULL;
+            }
+            h = (h ^ (unsigned)_orders[i].GetArrival()) * 1099511628211ULL;
+        }
+        return h;
+    }
+    /* Schedule() - selects the next dish to be cooked on a stove
+     *            - argument is index of the stove
+     *            - returns index (in _dishes) of dish to be cooked
+     */
+    int Schedule(int s)
+    {
+        Stove &stove = _stoves[s];
+        int onStove = stove.GetDish();
+        int before = (onStove > -1) ? _dishes.at(onStove).GetPriority() : 0;
+
+        // Dishes already on another stove are passed over
+        int quantum;
+        int k = _policy.Pick(_dishes, onStove, _config, quantum,
+            [this, s](int j) { return StoveOf(j) > -1 && StoveOf(j) != s; });
+        stove.SetQuantum(quantum);
+
+        // Switch-aware: rather than clean the stove for another recipe, take
+        //  a dish just as far up in line with the recipe already on it
+        if (_switchAware && k > -1 && k != onStove && stove.GetStatus() == STOVE_DIRTY && !SameRecipe(k, stove.GetLast()))
+        {
+            int last = stove.GetLast();
+            int j = _policy.Sibling(_dishes, k,
+                [this, s, last](int j) { return SameRecipe(j, last) && (StoveOf(j) == -1 || StoveOf(j) == s); });
+            k = (j > -1) ? j : k;
+        }
+
+        if (onStove > -1 && _dishes.at(onStove).GetPriority() < before)
+        {
+            Trace(TR_DEMOTE, onStove, _dishes.at(onStove).GetPriority() - 1);
+        }
+
+        #ifdef DEBUG
+        cout << "  STOVE:  " << s << "  CHOOSE:  " << k << "  Q:  " << quantum << endl;
+        #endif
+
+        return k;
+    }
+    /* SameRecipe() - returns true if dishes a and b are both there and
+     *                follow the same recipe
+     */
+    bool SameRecipe(int a, int b)
+    {
+        // By name, which is stored once: in Monte Carlo mode dishes of the
+        //  same recipe may have recipes of their own
+        return a > -1 && b > -1 && &_dishes.at(a).GetName() == &_dishes.at(b).GetName();
+    }
+    /* StoveOf() - returns index of the stove dish i is on (-1 if none)
+     */
+    int StoveOf(int i)
+    {
+        for (int s = 0; s < _stoves.size(); s++)
+        {
+            if (_stoves[s].GetDish() == i)
+            {
+                return s;
+            }
+        }
+        return -1;
+    }
+    /* StoveName() - returns name of stove s as used in output
+     */
+    string StoveName(int s)
+    {
+        return stove_name(s, _stoves.size());
+    }
+    string Lower(string s) // lowercase copy of s
+    {
+        transform(s.begin(), s.end(), s.begin(), ::tolower);
+        return s;
+    }
+    /* StoveRemark() - returns the remark for cleaning (or preheating)
+     *                 stove s, e.g. "Cleaning stove 2. "; made once per
+     *                 stove, not every "second"
+     */
+    const string& StoveRemark(int s, bool preheat)
+    {
+        if (_stoveRemarks.size() != 2 * _stoves.size())
+        {
+            _stoveRemarks.clear();
+            for (int k = 0; k < _stoves.size(); k++)
+            {
+                _stoveRemarks.push_back("Cleaning " + Lower(StoveName(k)) + ". ");
+                _stoveRemarks.push_back("Preheating " + Lower(StoveName(k)) + ". ");
+            }
+        }
+        return _stoveRemarks[2 * s + preheat];
+    }
+    /* TakeAssistant() - gives dish i an assistant for its PREP task, or
+     *                   puts it in line for one if all are busy
+     *                 - returns true if dish i got an assistant
+     */
+    bool TakeAssistant(int i)
+    {
+        if (_assistants == 0)
+        {
+            return true; // No limit on assistants
+        }
+        if (_prepLine.empty())
+        {
+            for (int a = 0; a < _assistants; a++)
+            {
+                if (_prepSlots[a] == -1)
+                {
+                    _prepSlots[a] = i;
+                    return true;
+                }
+            }
+        }
+        _prepLine.push_back(i);
+        return false;
+    }
+    /* ReleaseAssistant() - frees the assistant working on dish i, if any
+     */
+    void ReleaseAssistant(int i)
+    {
+        for (int a = 0; a < _assistants; a++)
+        {
+            if (_prepSlots[a] == i)
+            {
+                _prepSlots[a] = -1;
+                return;
+            }
+        }
+    }
+    /* ServePrepLine() - hands free assistants to dishes waiting in line;
+     *                   they start prepping on the next "second"
+     */
+    void ServePrepLine()
+    {
+        for (int a = 0; a < _assistants && !_prepLine.empty(); a++)
+        {
+            if (_prepSlots[a] == -1)
+            {
+                int i = _prepLine.front();
+                _prepLine.pop_front();
+                _prepSlots[a] = i;
+                _lives.Resume(i);
+            }
+        }
+    }
+    /* TakeOrders() - online mode: takes in orders until the next "second"
+     *                is due, i.e. at wall-clock pace or, when replaying,
+     *                until an order arrives after the next "second"
+     *              - returns number of dishes added
+     */
+    int TakeOrders()
+    {
+        int added = 0;
+        Recipe *recipe;
+        int at;
+        while (true)
+        {
+            while (_feed->NextOrder(recipe, at))
+            {
+                // Orders without a time (or for the past) arrive next "second"
+                at = max(at, _time + 1);
+                Admit(recipe, at);
+                _horizon = max(_horizon, at);
+                added++;
+            }
+            if (_speed > 0)
+            {
+                // Kept at wall-clock pace even after the last order
+                chrono::duration<double> due((_time + 1) / _speed);
+                chrono::duration<double> left = due - (chrono::steady_clock::now() - _start);
+                if (left.count() <= 0)
                 {
-                    // Equivalent of IO Blocking
-                    //   'Promote' Dish/Process one level higher
-                    // Temporarily remove from scheduling queue to move elsewhere
-                    bool notDone = true;
-                    int y;
-                    for (y = 0; y < QUEUE_COUNT && notDone; y++)
+                    return added;
+                }
+                if (_feed->IsOpen())
+                {
+                    _feed->Wait((int)(left.count() * 1000) + 1);
+                }
+                else
+                {
+                    this_thread::sleep_for(left);
+                }
+            }
+            else if (_feed->IsOpen() && _horizon <= _time + 1)
+            {
+                _feed->Wait(-1);
+            }
+            else
+            {
+                return added;
+            }
+        }
+    }
+    /* Admit() - online mode: lines up an order until it arrives
+     *         - arguments are its recipe and arrival time
+     */
+    void Admit(Recipe *recipe, int at)
+    {
+        // Arrived orders are dropped from the line-up once in a while
+        if (_nextIncoming > 1024 && _nextIncoming * 2 > _incoming.size())
+        {
+            _incoming.erase(_incoming.begin(), _incoming.begin() + _nextIncoming);
+            _nextIncoming = 0;
+        }
+        // After every order arriving at the same time or earlier
+        vector<pair<int, Order> >::iterator it = upper_bound(_incoming.begin() + _nextIncoming, _incoming.end(), at,
+            [](int at, pair<int, Order> &o) { return at < o.second.GetArrival(); });
+        _incoming.insert(it, make_pair(_ordered++, Order(recipe, at)));
+    }
+    /* Arriving() - takes the next order that arrives by now, if any
+     *            - argument is set to its number (in the tasklist, or in
+     *              the stream online)
+     *            - returns the order (NULL if none)
+     */
+    Order * Arriving(int &number)
+    {
+        if (_feed != NULL)
+        {
+            if (_nextIncoming < _incoming.size() && _incoming[_nextIncoming].second.GetArrival() <= _time)
+            {
+                number = _incoming[_nextIncoming].first;
+                return &_incoming[_nextIncoming++].second;
+            }
+        }
+        else if (_nextArrival < _arrivals.size() && _orders[_arrivals[_nextArrival]].GetArrival() <= _time)
+        {
+            number = _arrivals[_nextArrival++];
+            return &_orders[number];
+        }
+        return NULL;
+    }
+    /* Retire() - sums up the metrics of dishes that are done and no longer
+     *            needed by a stove, and lets them leave the kitchen
+     */
+    void Retire()
+    {
+        int kept = 0;
+        for (int f = 0; f < _finished.size(); f++)
+        {
+            int i = _finished[f];
+            // Not until its stove moves on (the last recipe on a stove
+            //  decides whether it needs cleaning)
+            bool needed = false;
+            for (int s = 0; s < _stoves.size(); s++)
+            {
+                needed = needed || _stoves[s].GetDish() == i || _stoves[s].GetLast() == i;
+            }
+            if (needed)
+            {
+                _finished[kept++] = i;
+                continue;
+            }
+            DishRef d = _dishes.at(i);
+            _retiredWeight += d.GetInitPriority() * d.GetWaitingTime();
+            _retiredPriority += d.GetInitPriority();
+            _dishes.Release(i);
+        }
+        _finished.resize(kept);
+    }
+    /* Expect() - records an upcoming event (event-driven mode only)
+     *          - arguments are time, type and index of affected dish
+     */
+    void Expect(int time, event_type type, int dish)
+    {
+        if (_eventDriven)
+        {
+            _events.push(SimEvent(time, type, dish));
+        }
+    }
+    /* IsQuiet() - returns true if the next "second" cannot change anything
+     *             but timers: no dispatch, no preemption, no stove cleaning.
+     *             Arrivals and task completions are covered by the events.
+     */
+    bool IsQuiet()
+    {
+        int busy = 0; // Stoves with a dish on them
+        for (int s = 0; s < _stoves.size(); s++)
+        {
+            int k = _stoves[s].GetDish();
+            if (k > -1)
+            {
+                // Dish on stove keeps cooking until its quantum runs out
+                if (_dishes.at(k).GetState() != READY || _stoves[s].GetQuantum() <= 1)
+                {
+                    return false;
+                }
+                busy++;
+            }
+        }
+        // A stove is empty but something could be put on it
+        return busy == _stoves.size() || _dishes.Count(READY) == busy;
+    }
+    /* SkipQuiet() - jumps the clock to just before the next event, if the
+     *               "seconds" in between are quiet
+     *             - argument is the row writer for output
+     */
+    void SkipQuiet(RowWriter &rows)
+    {
+        // Discard events that have already been processed
+        while (!_events.empty() && _events.top().GetTime() <= _time)
+        {
+            _events.pop();
+        }
+        if (_events.empty() || !IsQuiet())
+        {
+            return;
+        }
+        int dt = _events.top().GetTime() - _time - 1;
+        if (dt < 1)
+        {
+            return;
+        }
+        // All skipped "seconds" look like the first one, minus the timers
+        if (rows.Wants())
+        {
+            _row.clear();
+            Columns(_row);
+            rows.Range(_time + 1, _time + dt, _row);
+        }
+        SampleQueues(dt);
+
+        // Dish on stove is READY in between "seconds" too
+        for (int i = _dishes.First(READY); i > -1; i = _dishes.NextIn(i))
+        {
+            _dishes[i].Wait(dt);
+        }
+        for (int i = _dishes.First(PREPPING); i > -1; i = _dishes.NextIn(i))
+        {
+            _dishes[i].Step(dt);
+        }
+        for (int s = 0; s < _stoves.size(); s++)
+        {
+            if (_stoves[s].GetDish() > -1)
+            {
+                _dishes.at(_stoves[s].GetDish()).Step(dt);
+                _stoves[s].Use(dt);
+                _stoves[s].SetQuantum(_stoves[s].GetQuantum() - dt);
+            }
+        }
+        for (int a = 0; a < _assistants; a++)
+        {
+            if (_prepSlots[a] > -1)
+            {
+                _prepUtil[a] += dt;
+            }
+        }
+        _time += dt;
+    }
+    /* Finish() - records the times of dish i, done this "second"
+     */
+    void Finish(int i)
+    {
+        DishRef d = _dishes.at(i);
+        int turnaround = _time - d.GetArrival() + 1;
+        int response = (d.GetFirstCook() > -1) ? d.GetFirstCook() - d.GetArrival() : -1;
+        _metrics.Add(d.GetName(), d.GetInitPriority(), turnaround, response, d.GetWaitingTime());
+        if (_dishLog)
+        {
+            *_dishLog << (_orderIds.empty() ? d.GetOrder() : _orderIds[d.GetOrder()]) + 1 << ", " << d.GetName() << ", " << d.GetInitPriority() << ", " << d.GetArrival() << ", ";
+            if (d.GetFirstCook() > -1)
+            {
+                *_dishLog << d.GetFirstCook();
+            }
+            *_dishLog << ", " << _time << ", " << turnaround << ", ";
+            if (response > -1)
+            {
+                *_dishLog << response;
+            }
+            *_dishLog << ", " << d.GetWaitingTime() << "\n";
+        }
+    }
+    /* SampleQueues() - counts the queue lengths into the stats, if on
+     *                - argument is number of "seconds" they last
+     */
+    void SampleQueues(int dt)
+    {
+        if (_stats.IsOn())
+        {
+            for (int level = 0; level < _policy.Levels(_config); level++)
+            {
+                _stats.Sample(level, _policy.Length(level), dt);
+            }
+        }
+    }
+    /* Columns() - formats the Stove, Ready and Assistants columns
+     *           - argument is the string they are added to
+     */
+    void Columns(string &out)
+    {
+        // Print Dish on each stove
+        for (int s = 0; s < _stoves.size(); s++)
+        {
+            if (_stoves[s].GetDish() > -1)
+            {
+                _dishes.at(_stoves[s].GetDish()).AppendTo(out);
+            }
+            else
+            {
+                out += "-- Idle --";
+            }
+            out += ", ";
+        }
+        // Print Ready, in tasklist order
+        InOrder(READY);
+        for (int k = 0; k < _byOrder.size(); k++)
+        {
+            if (StoveOf(_byOrder[k].second) == -1)
+            {
+                _dishes[_byOrder[k].second].AppendTo(out);
+                out += "   ";
+            }
+        }
+        out += ", ";
+        // Print Assistants/Prep, then dishes waiting for an assistant
+        InOrder(PREPPING);
+        for (int k = 0; k < _byOrder.size(); k++)
+        {
+            _dishes[_byOrder[k].second].AppendTo(out);
+            out += "   ";
+        }
+        for (deque<int>::iterator it = _prepLine.begin(); it != _prepLine.end(); ++it)
+        {
+            out += '[';
+            _dishes.at(*it).AppendTo(out);
+            out += "]   ";
+        }
+        out += ", ";
+    }
+    /* InOrder() - puts the dishes in state st in _byOrder as (number of
+     *             order, handle), in tasklist order
+     */
+    void InOrder(dish_state st)
+    {
+        _byOrder.clear();
+        for (int i = _dishes.First(st); i > -1; i = _dishes.NextIn(i))
+        {
+            _byOrder.push_back(make_pair(_dishes[i].GetOrder(), i));
+        }
+        sort(_byOrder.begin(), _byOrder.end());
+    }
+    /* Life() - the life cycle of dish i, from its arrival until it is done,
+     *          as a coroutine:
+     *            COOK -> in line for a stove (READY), a "second" of
+     *                    cooking at a time (ONSTOVE);
+     *            PREP -> with an assistant as soon as one is free
+     *                    (PREPWAIT, then PREPPING); a dish coming off a
+     *                    stove first spends one "second" MOVING over.
+     *          It waits on the awaiters below. Proceed() resumes it when
+     *          the tick kernel hands the dish over (after its "second" of
+     *          work), ServePrepLine() when it gets an assistant.
+     *          A dish restored from a snapshot picks up from its state.
+     *        - argument is index of dish
+     */
+    DishLife Life(int i)
+    {
+        // Every frame costs memory for as long as its dish is in the
+        //  kitchen, and the DishTable may grow while the dish waits, so
+        //  the frame keeps only the kind of the next task; where the dish
+        //  is is its state in the DishTable
+        int next = NextType(i);
+        if (_dishes.at(i).GetState() == NOTARRIVED)
+        {
+            Arrive(i);
+        }
+        while (next != -1)
+        {
+            if (next == COOK)
+            {
+                while (true)
+                {
+                    co_await StoveAwaiter();
+                    next = NextType(i);
+                    if (next != COOK)
                     {
-                        for (int z = 0; z < _mfqs[y].size(); z++)
-                        {
-                            if (_mfqs[y][z] == i)
-                            {
-                                _mfqs[y].erase(_mfqs[y].begin() + z);
-                                notDone = false;
-                                y -= 1;
-                                break;
-                            }
-                        }
+                        break;
                     }
-                    // Push into one level higher
-                    int higher = (y == QUEUE_COUNT - 1) ? QUEUE_COUNT - 1 : y + 1;
-                    _mfqs[higher].push_back(i);
-                    _dishes.at(i).SetPriority(higher + 1);
-
-                    #ifdef DEBUG
-                    cout << endl << "$ Promote Dish " << i << " from level " << y << " to " << higher << endl;
-                    #endif
+                    // In Ready queue, i.e. Dish is WAITING, in between
+                    //  "seconds" on a stove too
+                    SetState(i, READY);
+                    _dishes.at(i).Wait();
+                }
+                if (next == -1)
+                {
+                    break;
+                }
+                SetState(i, MOVING);
+                // Off to the assistants, out of line for the stove
+                _policy.Leave(_dishes, i);
+            }
+            if (_dishes.at(i).GetState() == MOVING)
+            {
+                co_await TimerAwaiter();
+            }
+            if (_dishes.at(i).GetState() != PREPPING)
+            {
+                int left = co_await AssistantAwaiter(*this, i);
+                Expect(_time + left, EV_TASK, i);
+            }
+            // PREP tasks one after another, with the same assistant
+            do
+            {
+                co_await TimerAwaiter();
+                next = NextType(i);
+            } while (next == PREP);
+            if (next == -1)
+            {
+                break;
+            }
+            BackToStove(i);
+        }
+        Done(i);
+    }
+    /*
+     * StoveAwaiter - Life(): in line for a stove (READY) until it has
+     *                cooked on one for a "second"
+     */
+    class StoveAwaiter
+    {
+    public:
+        bool await_ready()
+        {
+            return false;
+        }
+        void await_suspend(coroutine_handle<>)
+        {
+        }
+        void await_resume()
+        {
+        }
+    };
+    /*
+     * AssistantAwaiter - Life(): an assistant for the PREP task, right away
+     *                    if one is free, else in line for one (PREPWAIT)
+     *                    until ServePrepLine() hands it over; gives the
+     *                    "seconds" of PREP left once it is PREPPING
+     */
+    class AssistantAwaiter
+    {
+    public:
+        AssistantAwaiter(BasicScheduler &s, int i) : _s(s), _i(i) { }
+        bool await_ready()
+        {
+            // A dish restored from a snapshot may be in line already
+            return _s._dishes.at(_i).GetState() != PREPWAIT && _s.TakeAssistant(_i);
+        }
+        void await_suspend(coroutine_handle<>)
+        {
+            _s.SetState(_i, PREPWAIT); // Must wait for an assistant
+        }
+        int await_resume()
+        {
+            DishRef d = _s._dishes.at(_i);
+            int left = d.GetNextTask()->GetTime();
+            if (d.GetState() == NOTARRIVED)
+            {
+                left--; // First "second" of PREP happens right away
+            }
+            _s.SetState(_i, PREPPING); // Must be prepped
+            return left;
+        }
+    private:
+        BasicScheduler &_s;
+        int _i;
+    };
+    /*
+     * TimerAwaiter - Life(): sleeps until the tick kernel hands the dish
+     *                over: the task being prepped is in its last "second",
+     *                or a dish has moved over
+     */
+    class TimerAwaiter
+    {
+    public:
+        bool await_ready()
+        {
+            return false;
+        }
+        void await_suspend(coroutine_handle<>)
+        {
+        }
+        void await_resume()
+        {
+        }
+    };
+    int NextType(int i) // type of the next task of dish i (-1 if it has none left)
+    {
+        Task * t = _dishes.at(i).GetNextTask();
+        return (t == NULL) ? -1 : t->GetType();
+    }
+    /* Arrive() - hands dish i, which just arrived, to the scheduling policy
+     */
+    void Arrive(int i)
+    {
+        _active++;
+        bool cook = (NextType(i) == COOK);
+        _policy.Arrive(_dishes, i, cook, _config);
+        if (cook)
+        {
+            SetState(i, READY); // Ready for cooking
+        }
+    }
+    /* BackToStove() - puts dish i, done with its PREP tasks, back in line
+     *                 for a stove
+     */
+    void BackToStove(int i)
+    {
+        SetState(i, READY);
+        // In Ready queue, i.e. Dish is WAITING; increment waiting time
+        _dishes.at(i).Wait();
+        ReleaseAssistant(i);
+        // MLFQ promotes it
+        int before = _dishes.at(i).GetPriority();
+        _policy.Ready(_dishes, i, _config);
+        if (_dishes.at(i).GetPriority() > before)
+        {
+            Trace(TR_PROMOTE, i, _dishes.at(i).GetPriority() - 1);
+        }
+    }
+    /* Done() - dish i has no more tasks in its recipe
+     */
+    void Done(int i)
+    {
+        _remarks += _dishes.at(i).GetName();
+        _remarks += " is Done. ";
+        if (_dishes.at(i).GetState() == PREPPING)
+        {
+            ReleaseAssistant(i);
+        }
+        // Set state to DONE, so it is ignored
+        SetState(i, DONE);
+        Finish(i);
+        _active--;
+        _finished.push_back(i);
+        // Remove from scheduling queue
+        _policy.Done(_dishes, i);
+    }
+    /* Work() - does a "second" of the task of dish i if it is on a stove
+     *          or with an assistant (a dish in line or moving over only
+     *          waits); the assistant goes on with a PREP task that follows
+     */
+    void Work(int i)
+    {
+        DishRef d = _dishes.at(i);
+        // Remember which task this was; stepping may move on to the next
+        int prevTask = d.GetTaskIndex();
+        dish_state dS = d.GetState();
+        if (dS == ONSTOVE || dS == PREPPING)
+        {
+            d.Step();
+        }
+        Task * t = d.GetNextTask();
+        if (t != NULL && d.GetTaskIndex() != prevTask)
+        {
+            Trace(TR_TASK, i, t->GetType(), t->GetTime());
+            if (dS == PREPPING && t->GetType() == PREP)
+            {
+                Expect(_time + t->GetTime(), EV_TASK, i);
+            }
+        }
+    }
+    /* SetState() - changes the state of a dish (the DishTable keeps track
+     *              of the dishes in each state)
+     *            - arguments are index of dish and new state
+     */
+    void SetState(int i, dish_state s)
+    {
+        DishRef d = _dishes.at(i);
+        if (d.GetState() == s)
+        {
+            return;
+        }
+        d.SetState(s);
+        Trace(TR_STATE, i, s);
+    }
+    void Trace(trace_kind kind, int dish, int a = 0, int b = 0) // add a record to the trace, if any
+    {
+        _stats.Count(kind, dish);
+        if (_trace)
+        {
+            // The trace knows dishes by the number of their order
+            _trace->Record(kind, (dish > -1) ? _dishes.at(dish).GetOrder() : -1, a, b);
+        }
+    }
+    /* Proceed() - moves the simulation one step forward in time
+     *           - arguments are number of Dishes not done & row writer
+     *           - returns number of Dishes not done;
+     */
+    int Proceed(int n, RowWriter &rows) // argument : row writer where output is to be printed
+    {
+        _remarks.clear(); // Remarks of this "second" (the buffer is reused)
+        unsigned long long mark = _stats.Start(); // Start of the phase being timed
+        _time++; // Time travel (1 second ahead)
+        if (_trace)
+        {
+            _trace->SetClock(_time, false);
+        }
+        for (int s = 0; s < _stoves.size(); s++)
+        {
+            _stoves[s].SetQuantum(_stoves[s].GetQuantum() - 1); // Go closer to next quantum
+        }
+
+        #ifdef DEBUG
+        cout << _time << "  ";
+        #endif
+
+        #ifdef DEBUG
+        _policy.Print(_dishes, cout);
+        cout << endl;
+        #endif
+
+        /**** Priority boost ****/
+        // Every so often, all dishes in the queues go back to the top one
+        //  so that dishes demoted to the bottom do not starve
+        int boost = _config.GetBoost();
+        if (boost > 0 && _time % boost == 0)
+        {
+            if (_active > 0 && _policy.Boost(_dishes, _config))
+            {
+                _boosts++;
+                _remarks += "Priority boost. ";
+                Trace(TR_BOOST, -1);
+            }
+            Expect(_time + boost, EV_BOOST, -1);
+        }
+
+        /**** Check if a dish is arriving ****/
+        // A Dish has "arrived" if its arrival time is equal to current "time"
+        //  (orders are sorted, so the rest arrive later); only then does it
+        //  get a place in the kitchen
+        int number;
+        for (Order *o = Arriving(number); o != NULL; o = Arriving(number))
+        {
+            int i = _dishes.Add(o->GetRecipe(), o->GetArrival(), number);
+
+            // Add to Remarks
+            _remarks += _dishes.at(i).GetName();
+            _remarks += " arrives. ";
+
+            Task * t = _dishes.at(i).GetNextTask();
+            Trace(TR_ARRIVE, i, t->GetType(), t->GetTime());
+            _lives.Start(i, Life(i));
+        }
+        _stats.Phase(PH_ARRIVE, mark);
+        /**** Select which one to cook next on each stove ****/
+        for (int s = 0; s < _stoves.size(); s++)
+        {
+            Stove &stove = _stoves[s];
+            int onStove = stove.GetDish();
+
+            // Keep cooking until the quantum runs out
+            //  (switch-aware: or until done, if that is sooner than a switch)
+            int k;
+            bool keep = stove.GetQuantum() > 0 || (_switchAware && onStove > -1 && _dishes.at(onStove).GetNextTask() != NULL && _dishes.at(onStove).GetNextTask()->GetTime() <= STOVE_SWITCH);
+            if (keep && onStove > -1 && _dishes.at(onStove).GetState() == READY)
+            {
+                k = onStove;
+            }
+            else
+            {
+                _stats.Phase(PH_STOVE, mark);
+                k = Schedule(s);
+                _stats.Phase(PH_SCHEDULE, mark);
+            }
+
+            // if Stove is clean or dish isn't changed, proceed normally
+            //  (switch-aware: a dish of the same recipe needs no cleaning)
+            if (k == onStove || stove.GetStatus() == STOVE_CLEAN || (_switchAware && stove.GetStatus() == STOVE_DIRTY && SameRecipe(k, stove.GetLast())))
+            {
+                stove.SetDish(k);
+                // The stove is "dirty" now iff. it is not empty
+                if (k > -1) stove.SetStatus(STOVE_DIRTY);
+            }
+            // Stove is dirty and dish needs to be changed
+            else if (stove.GetStatus() == STOVE_DIRTY)
+            {
+                stove.SetDish(-1);
+                _remarks += StoveRemark(s, false);
+                Trace(TR_CLEAN, -1, s);
+                stove.CountSwitch();
+                stove.CountLost();
+                stove.SetStatus(stove.GetStatus() + 1); // 1 step towards a clean stove
+            }
+            // Dish needs to be changed and stove is almost clean
+            else
+            {
+                stove.SetDish(-1);
+                _remarks += StoveRemark(s, true);
+                Trace(TR_PREHEAT, -1, s);
+                stove.CountLost();
+                stove.SetStatus(stove.GetStatus() + 1); // Stove is clean next time
+            }
+
+            if (stove.GetDish() != onStove)
+            {
+                if (onStove > -1 && _dishes.at(onStove).GetState() == READY)
+                {
+                    Trace(TR_PREEMPT, onStove, s);
                 }
+                Trace(TR_STOVE, stove.GetDish(), s);
+            }
+
+            if (stove.GetDish() > -1)
+            {
+                SetState(stove.GetDish(), ONSTOVE);
+                if (_dishes.at(stove.GetDish()).GetFirstCook() == -1)
+                {
+                    _dishes.at(stove.GetDish()).SetFirstCook(_time);
+                }
+            }
+        }
+
+        SampleQueues(1);
+        _stats.Phase(PH_STOVE, mark);
+
+        /**** Cook ****/
+
+        // Print Dish on stove, Ready and Assistants/Prep
+        _row.clear();
+        if (rows.Wants())
+        {
+            Columns(_row);
+        }
+        _stats.Phase(PH_OUTPUT, mark);
+        if (_trace)
+        {
+            _trace->SetClock(_time, true);
+        }
+        for (int s = 0; s < _stoves.size(); s++)
+        {
+            if (_stoves[s].GetDish() > -1)
+            {
+                _stoves[s].Use(1);
             }
-            else if (t->GetType() == PREP)
+        }
+        for (int a = 0; a < _assistants; a++)
+        {
+            if (_prepSlots[a] > -1)
+            {
+                _prepUtil[a] += 1;
+            }
+        }
+
+        // Dishes that only wait or prep on are done all at once; the rest
+        //  (of those that have arrived and are not done) one at a time
+        int m = _dishes.Tick(_rest);
+        for (int r = 0; r < m; r++)
+        {
+            // A "second" of its task, and on to whatever the next task
+            //  waits for
+            Work(_rest[r]);
+            if (_lives.Resume(_rest[r]))
+            {
+                n -= 1; // decrease number of dishes not done yet
+            }
+        }
+        // Assistants freed up this "second" take the next dishes in line
+        ServePrepLine();
+        _stats.Phase(PH_TASKS, mark);
+
+        // Print Time, columns and Remarks
+        if (rows.Wants())
+        {
+            _row += _remarks;
+            rows.Row(_time, _row);
+        }
+        _stats.Phase(PH_OUTPUT, mark);
+
+        // Dish kept on stove cooks until its task or quantum runs out
+        for (int s = 0; s < _stoves.size(); s++)
+        {
+            int k = _stoves[s].GetDish();
+            if (k > -1 && _dishes.at(k).GetState() == READY)
             {
-                if (dS == ONSTOVE)
-                {
-                    _dishes.at(i).SetState(MOVING);
-                }
-                else
-                {
-                    _dishes.at(i).SetState(PREPPING);
-                }
+                Expect(_time + _dishes.at(k).GetNextTask()->GetTime(), EV_TASK, k);
+                Expect(_time + _stoves[s].GetQuantum(), EV_QUANTUM, k);
             }
         }
-        // Print Remarks
-        out << remarks << endl;
 
         /*** Return number of dishes not yet done ***/
         return n;
     }
-    vector<Dish> _dishes;
-    int _onStove; // Index in _dishes of Dish currently On Stove
+    vector<Order> _orders; // Dishes in the tasklist, by index
+    DishTable _dishes; // Dishes in the kitchen, by handle
+    DishLives _lives; // Life cycle of each dish in the kitchen that is not done
     int _time; // Simulated time
-    int _stoveUtil; // stove utilization time
-    int _stoveStatus; // Stove status (from DIRTY to CLEAN, with 1 step in between)
-
-    int _quantum; // Current time quantum
-    // Multiple Feedback queues
-    vector<int> _mfqs[QUEUE_COUNT]; // an array of size QUEUE_COUNT of int vectors (ref)
-                                    // each int vector is a queue.
-    int _chosenOne; // Index of last chosen queue
+
+    // Stoves, each with its own dish, clean/preheat status and quantum
+    vector<Stove> _stoves;
+    // Assistants for PREP tasks
+    int _assistants; // Number of assistants (0 for no limit)
+    vector<int> _prepSlots; // Index in _dishes of Dish each assistant is prepping (-1 if free)
+    vector<int> _prepUtil; // Utilization time per assistant
+    deque<int> _prepLine; // Dishes waiting for an assistant, first come first served
+
+    // Scheduling policy (multiple feedback queues by default)
+    SchedulerConfig _config; // queue count, quantum table, boost interval
+    Policy _policy; // who gets the stoves next
+    int _boosts; // Number of priority boosts so far
+
+    int _active; // Number of dishes that have arrived and are not done yet
+    vector<int> _rest; // Dishes that need a decision this "second" (see DishTable::Tick())
+    vector<int> _arrivals; // Orders of the tasklist sorted by arrival time
+    vector<int> _finished; // Dishes done but not yet retired
+    double _retiredWeight; // Sum of priority * waiting time of dishes that left
+    long _retiredPriority; // Sum of priority of dishes that left
+    int _nextArrival; // Position in _arrivals of next dish to arrive
+    vector<pair<int, Order> > _incoming; // Online: (number, order) of orders taken in, by arrival time
+    int _nextIncoming; // Position in _incoming of next dish to arrive
+    int _ordered; // Online: number of orders taken in so far
+
+    bool _eventDriven; // Jump over quiet "seconds" instead of stepping through
+    bool _collapse; // Merge consecutive identical output rows
+    bool _switchAware; // Weigh cleaning/preheating time in dispatch
+    EventQueue _events; // Upcoming events (event-driven mode only)
+
+    string _outputFile; // Where the schedule is written
+    string _perfLogFile; // Where the performance metrics are written
+    string _traceFile; // Where the binary trace is written ("" for none)
+
+    // Online mode
+    OrderFeed *_feed; // Where orders come from (NULL if offline)
+    double _speed; // Simulated "seconds" per wall-clock second (0 to replay)
+    chrono::steady_clock::time_point _start; // Wall-clock time at "second" 0
+    int _horizon; // Latest arrival time ordered so far
+    TraceWriter *_trace; // Binary trace of the running simulation, if any
+
+    DishMetrics _metrics; // Turnaround, response and waiting times of dishes done
+    string _dishLogFile; // Where the times of every dish are written ("" for none)
+    ostream *_dishLog; // Open dish log of the running simulation, if any
+
+    // Buffers of Proceed(), kept so that rows are built without allocating
+    string _remarks; // Remarks of the current "second"
+    string _row; // Row being written, minus the time
+    vector<pair<int, int> > _byOrder; // Dishes of a column as (number of order, handle), see InOrder()
+    vector<string> _stoveRemarks; // Cleaning and preheating remark of each stove
+
+    SimStats _stats; // Hot-path counters (off by default)
+    string _statsFile; // Where the counters are written as JSON ("" for none)
+
+    // Snapshots (see snapshot.cpp)
+    int _checkpoint; // "Seconds" between snapshots (0 for none)
+    int _checkpointDue; // Time of the next snapshot
+    string _checkpointFile; // Where snapshots are written ("{t}" is the time)
+    string _resumeFile; // Snapshot to go on from ("" to start at 0)
+
+    // Split runs
+    int _parallel; // Threads simulating stretches between idle spells (0 or 1 for none)
+    int _stop; // Time at which a stretch ends (0 for none)
+    vector<int> _orderIds; // Number in the tasklist of each order of a stretch
+};
+
+/* run_with_policy() - simulates with the dishes and settings of core under
+ *                     another policy, then moves the results back
+ */
+template <class Policy>
+void run_with_policy(Scheduler &core)
+{
+    BasicScheduler<Policy> run;
+    run.MoveFrom(core);
+    run.Sim();
+    core.MoveFrom(run);
+}
+template <>
+void run_with_policy<MlfqPolicy>(Scheduler &core)
+{
+    core.Sim(); // Default build, nothing to copy
+}
+
+/*
+ * PolicyRegistry - the scheduling policies that can be chosen by name.
+ */
+class PolicyRegistry
+{
+public:
+    static PolicyRegistry& Get() // the one registry
+    {
+        static PolicyRegistry registry;
+        return registry;
+    }
+    bool Has(const string &name) // returns true if there is a policy called 'name'
+    {
+        return _runs.count(name) > 0;
+    }
+    string Names() // names of all policies, e.g. "edf, fcfs, mlfq"
+    {
+        string names;
+        for (map<string, void (*)(Scheduler &)>::iterator it = _runs.begin(); it != _runs.end(); ++it)
+        {
+            names += (names.empty() ? "" : ", ") + it->first;
+        }
+        return names;
+    }
+    void Run(Scheduler &core) // simulate under the policy named in core's configuration
+    {
+        _runs.at(core.GetConfig().GetPolicy())(core);
+    }
+private:
+    PolicyRegistry()
+    {
+        _runs["mlfq"] = run_with_policy<MlfqPolicy>;
+        _runs["fcfs"] = run_with_policy<FcfsPolicy>;
+        _runs["sjf"] = run_with_policy<SjfPolicy>;
+        _runs["srtf"] = run_with_policy<SrtfPolicy>;
+        _runs["prio-rr"] = run_with_policy<PriorityPolicy>;
+        _runs["edf"] = run_with_policy<EdfPolicy>;
+    }
+    map<string, void (*)(Scheduler &)> _runs;
 };
 
-int main()
+#ifndef SCHEDULER_NO_MAIN // defined by programs built on top of the scheduler (bench.cpp)
+int main(int argc, char *argv[])
 {
-    cout << endl << "CS 140 Machine Problem" << endl;
-    cout << "----------------------------" << endl;
-    cout << "Vincent Fiestada | 201369155" << endl << endl;
+    // Online, standard output is the CSV stream; the banner goes with the
+    //  other messages to standard error
+    ostream &banner = (find(argv + 1, argv + argc, string("--online")) != argv + argc) ? cerr : cout;
+    banner << endl << "CS 140 Machine Problem" << endl;
+    banner << "----------------------------" << endl;
+    banner << "Vincent Fiestada | 201369155" << endl << endl;
 
     Scheduler core = Scheduler();
+    string batch; // Directory or manifest of tasklists, if in batch mode
+    string trace; // Binary trace to write instead of the CSV schedule, if any
+    bool tune = false; // Search for the best scheduling parameters
+    string online; // Where orders come from, if in online mode
+    double speed = 1; // Simulated "seconds" per wall-clock second online
+    int checkpoint = 0; // "Seconds" between snapshots
+    string checkpointFile = SNAPSHOTFILE; // Where snapshots are written
+    string resume; // Snapshot to go on from, if any
+    bool parallel = false; // Simulate stretches between idle spells at once
+    int montecarlo = 0; // Replications with drawn times, if in Monte Carlo mode
+    unsigned long long seed = 1; // Seed of the random number streams
+    Spread jitter; // How arrivals vary, for recipes that do not say
+    int threads = thread::hardware_concurrency(); // One thread per core
 
-    // Opening input file
-    ifstream input(INPUTFILE);
-    string taskDesc;
-    if (input.is_open())
+    // Parse command line options
+    for (int i = 1; i < argc; i++)
     {
-        while (getline(input, taskDesc))
+        string opt = argv[i];
+        if (opt == "--event")
+        {
+            core.SetEventDriven(true);
+        }
+        else if (opt == "--collapse")
+        {
+            core.SetCollapse(true);
+        }
+        else if (opt == "--dish-log" && i + 1 < argc)
+        {
+            core.SetDishLog(argv[++i]);
+        }
+        else if (opt == "--checkpoint" && i + 1 < argc)
         {
-            // Parse by finding the space
-            size_t x = taskDesc.find(" ");
-            if (x != string::npos)
+            checkpoint = atoi(argv[++i]);
+            if (checkpoint < 1)
             {
-                // The name is the substr before the space
-                // The number is the substr after the space
-                int at = atoi(taskDesc.substr(x + 1).c_str()); // convert string to int
-                if (at < 1)
-                {
-                    input.close();
-                    fatal_err("Input file is corrupted. Invalid arrival time.", 3);
-                }
-                Dish d = Dish(taskDesc.substr(0, x), at, 0);
-                // Open recipe file and add recipe steps to dish d
-                string recipeFilename = "recipes/" + d.GetName() + ".txt";
-                ifstream recipeFile(recipeFilename.c_str());
-                if (recipeFile.is_open())
-                {
-                    string recipeLine;
-                    size_t y;
-                    if (getline(recipeFile, recipeLine))
-                    {
-                        // Parse by finding the space
-                        y = recipeLine.find(" ");
-                        if (y != string::npos)
-                        {
-                            // The priority is the number after the space
-                            int p = atoi(recipeLine.substr(y + 1).c_str()); // convert string to int
-                            // Check if priority is valid
-                            if (p < 1 || p > QUEUE_COUNT)
-                            {
-                                fatal_err("Recipe file '" + recipeFilename + "' is corrupted. Dish priority is missing.", 5);
-                            }
-                            d.SetPriority(p);
-                        }
-                        else
-                        {
-                            // space not found, trigger error
-                            fatal_err("Recipe file '" + recipeFilename + "' is corrupted. Dish priority is missing", 5);
-                        }
-                    }
-                    while(getline(recipeFile, recipeLine))
-                    {
-                        // Parse by finding the space
-                        y = recipeLine.find(" ");
-                        if (y != string::npos)
-                        {
-                            // Step description is before the space
-                            int ty = (recipeLine.substr(0, y) == "cook") ? COOK : PREP;
-                            // Step time is the number after the space
-                            int ti = atoi(recipeLine.substr(y + 1).c_str()); // convert string to int
-                            d.GetRecipe().push_back(Task(ty, ti)); // Push into recipe vector
-                        }
-                        else
-                        {
-                            // space not found, trigger error
-                            fatal_err("Recipe file '" + recipeFilename + "' is corrupted.", 5);
-                        }
-                    }
-                    recipeFile.close();
-
-                    // push into dishes
-                    core.GetDishes().push_back(d);
-                }
-                else
-                {
-                    fatal_err("Recipe file '" + recipeFilename + "' not found.", 4);
-                }
+                fatal_err("Option '--checkpoint' needs a positive number of \"seconds\".", 7);
+            }
+        }
+        else if (opt == "--checkpoint-file" && i + 1 < argc)
+        {
+            checkpointFile = argv[++i];
+        }
+        else if (opt == "--resume" && i + 1 < argc)
+        {
+            resume = argv[++i];
+        }
+        else if (opt == "--stats")
+        {
+            core.SetStats(true, core.GetStatsFile());
+        }
+        else if (opt == "--stats-file" && i + 1 < argc)
+        {
+            core.SetStats(true, argv[++i]);
+        }
+        else if (opt == "--switch-aware")
+        {
+            core.SetSwitchAware(true);
+        }
+        else if (opt == "--batch" && i + 1 < argc)
+        {
+            batch = argv[++i];
+        }
+        else if (opt == "--trace" && i + 1 < argc)
+        {
+            trace = argv[++i];
+            core.SetOutputFiles("", PERFLOGFILE, trace);
+        }
+        else if (opt == "--online" && i + 1 < argc)
+        {
+            online = argv[++i];
+        }
+        else if (opt == "--speed" && i + 1 < argc)
+        {
+            // 0 replays orders as fast as they come in
+            speed = atof(argv[++i]);
+            if (speed < 0)
+            {
+                fatal_err("Option '--speed' needs a number of at least 0.", 7);
+            }
+        }
+        else if (opt == "--policy" && i + 1 < argc)
+        {
+            string name = argv[++i];
+            if (!PolicyRegistry::Get().Has(name))
+            {
+                fatal_err("Unknown policy '" + name + "'. Choose one of: " + PolicyRegistry::Get().Names() + ".", 7);
+            }
+            core.GetConfig().SetPolicy(name);
+        }
+        else if (opt == "--kernel" && i + 1 < argc)
+        {
+            string name = argv[++i];
+            if (!TickKernels::Get().Set(name))
+            {
+                fatal_err("Tick kernel '" + name + "' is unknown or not supported by this CPU. Choose one of: scalar, sse2, avx2.", 7);
+            }
+        }
+        else if (opt == "--parallel")
+        {
+            parallel = true;
+        }
+        else if (opt == "--montecarlo" && i + 1 < argc)
+        {
+            montecarlo = atoi(argv[++i]);
+            if (montecarlo < 1)
+            {
+                fatal_err("Option '--montecarlo' needs a positive number of replications.", 7);
+            }
+        }
+        else if (opt == "--seed" && i + 1 < argc)
+        {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (opt == "--jitter" && i + 1 < argc)
+        {
+            if (!jitter.Parse(argv[++i]))
+            {
+                fatal_err("Option '--jitter' needs a distribution, e.g. \"normal 3\" or \"uniform -2 5\".", 7);
+            }
+        }
+        else if (opt == "--tune")
+        {
+            tune = true;
+        }
+        else if (opt == "--quanta" && i + 1 < argc)
+        {
+            vector<int> q = parse_list(argv[++i]);
+            if (q.empty() || *min_element(q.begin(), q.end()) < 1)
+            {
+                fatal_err("Option '--quanta' needs a list of positive numbers, e.g. 2,3,4.", 7);
+            }
+            core.GetConfig().SetQuanta(q);
+        }
+        else if (opt == "--boost" && i + 1 < argc)
+        {
+            // 0 turns the priority boost off
+            core.GetConfig().SetBoost(atoi(argv[++i]));
+        }
+        else if ((opt == "--stoves" || opt == "--assistants" || opt == "--threads" || opt == "--queues") && i + 1 < argc)
+        {
+            int count = atoi(argv[++i]);
+            if (count < 1)
+            {
+                fatal_err("Option '" + opt + "' needs a positive count.", 7);
+            }
+            if (opt == "--stoves")
+            {
+                core.SetStoves(count);
+            }
+            else if (opt == "--assistants")
+            {
+                core.SetAssistants(count);
+            }
+            else if (opt == "--queues")
+            {
+                core.GetConfig().SetQueueCount(count);
             }
             else
             {
-                input.close();
-                fatal_err("Input file is corrupted. Space delimiter missing.", 2);
+                threads = count;
             }
         }
-        input.close();
+        else
+        {
+            fatal_err("Unknown option '" + opt + "'.", 7);
+        }
     }
-    else
+
+    if (checkpoint > 0 || !resume.empty())
+    {
+        // Snapshots are of a single run with its output in files
+        if (!online.empty() || !batch.empty() || tune || !trace.empty())
+        {
+            fatal_err("Options '--checkpoint' and '--resume' cannot be used with '--online', '--batch', '--tune' or '--trace'.", 7);
+        }
+        core.SetCheckpoint(checkpoint, checkpointFile);
+        core.SetResume(resume);
+    }
+
+    if (parallel)
     {
-        fatal_err("File could not be opened.", 1);
+        // Runs of --batch and --tune are in parallel already
+        if (!online.empty() || !batch.empty() || tune || !trace.empty() || checkpoint > 0 || !resume.empty())
+        {
+            fatal_err("Option '--parallel' cannot be used with '--online', '--batch', '--tune', '--trace', '--checkpoint' or '--resume'.", 7);
+        }
+        core.SetParallel(threads);
+    }
+
+    if (montecarlo > 0)
+    {
+        // Replications are simulated in parallel already, without files
+        if (!online.empty() || !batch.empty() || tune || !trace.empty() || checkpoint > 0 || !resume.empty() || parallel)
+        {
+            fatal_err("Option '--montecarlo' cannot be used with '--online', '--batch', '--tune', '--trace', '--checkpoint', '--resume' or '--parallel'.", 7);
+        }
     }
 
-    core.Sim();
+    RecipeBook book;
+    if (!online.empty())
+    {
+        // Arrivals are not known in advance, and rows are shown as they happen
+        if (!batch.empty() || tune || !trace.empty() || core.IsEventDriven())
+        {
+            fatal_err("Option '--online' cannot be used with '--batch', '--tune', '--trace' or '--event'.", 7);
+        }
+        core.SetOutputFiles("-", PERFLOGFILE);
+        OrderFeed feed(open_order_source(online), book);
+        core.SetFeed(&feed, speed);
+        PolicyRegistry::Get().Run(core);
+    }
+    else if (!batch.empty())
+    {
+        run_batch(batch, book, core, threads);
+    }
+    else if (tune)
+    {
+        load_tasklist(INPUTFILE, book, core.GetOrders());
+        run_tuner(core, threads);
+    }
+    else if (montecarlo > 0)
+    {
+        load_tasklist(INPUTFILE, book, core.GetOrders());
+        run_montecarlo(core, montecarlo, seed, jitter, threads);
+    }
+    else
+    {
+        load_tasklist(INPUTFILE, book, core.GetOrders());
+        PolicyRegistry::Get().Run(core);
+    }
 
     return 0;
 }
+#endif
 
 void fatal_err(const string &s, int code)
 {
@@ -606,3 +2204,359 @@ void fatal_err(const string &s, int code)
     cout << "The error code is " << code << " in case you need it." << endl;
     exit(code);
 }
+
+/* load_tasklist() - reads a tasklist file into orders, stopping the
+ *                   program if it cannot
+ *                 - arguments are name of tasklist file, recipes to use
+ *                   & vector where orders are to be added
+ */
+void load_tasklist(const string &filename, RecipeBook &book, vector<Order> &orders)
+{
+    string error;
+    int code = read_tasklist(filename, book, orders, error);
+    if (code != 0)
+    {
+        fatal_err(error, code);
+    }
+}
+
+/* read_tasklist() - reads a tasklist file into orders
+ *                 - arguments are name of tasklist file, recipes to use,
+ *                   vector where orders are to be added & string for the
+ *                   error message
+ *                 - returns 0 if successful, else the error code
+ */
+int read_tasklist(const string &filename, RecipeBook &book, vector<Order> &orders, string &error)
+{
+    // Opening input file, mapped into memory and parsed in place
+    MappedFile input(filename);
+    if (!input.IsOpen())
+    {
+        error = "File could not be opened.";
+        return 1;
+    }
+    string_view text = input.GetText();
+    orders.reserve(orders.size() + count(text.begin(), text.end(), '\n') + 1);
+    LineReader reader(text);
+    string_view taskDesc;
+    while (reader.Next(taskDesc))
+    {
+        // Parse by finding the space
+        size_t x = taskDesc.find(' ');
+        if (x == string_view::npos)
+        {
+            error = "Input file is corrupted at " + reader.Where(taskDesc.size() + 1) + ". Space delimiter missing.";
+            return 2;
+        }
+        // The name is the part before the space
+        // The number is the part after the space
+        int at = 0;
+        size_t y = x + 1;
+        if (!LineReader::ParseInt(taskDesc, y, at) || at < 1)
+        {
+            error = "Input file is corrupted at " + reader.Where(y) + ". Invalid arrival time.";
+            return 3;
+        }
+        // Look up recipe (read once per dish name); the dish shares its steps
+        Recipe *recipe = book.Find(taskDesc.substr(0, x), error);
+        if (recipe == NULL && error.empty())
+        {
+            string recipeFilename = RECIPEDIR + string(taskDesc.substr(0, x)) + ".txt";
+            error = "Recipe file '" + recipeFilename + "' not found.";
+            return 4;
+        }
+        if (recipe == NULL)
+        {
+            return 5;
+        }
+        orders.push_back(Order(recipe, at));
+    }
+    return 0;
+}
+
+/* run_batch() - simulates many tasklists in parallel and writes a summary
+ *             - arguments are directory or manifest of tasklists, recipes,
+ *               configured scheduler to copy for each run & thread count
+ */
+void run_batch(const string &source, RecipeBook &book, Scheduler &proto, int threads)
+{
+    // Collect tasklists: every .txt file in a directory, or one per
+    //  line of a manifest
+    vector<string> tasklists;
+    if (filesystem::is_directory(source))
+    {
+        filesystem::directory_iterator it(source), end;
+        for (; it != end; ++it)
+        {
+            if (it->path().extension() == ".txt")
+            {
+                tasklists.push_back(it->path().string());
+            }
+        }
+        sort(tasklists.begin(), tasklists.end());
+    }
+    else
+    {
+        ifstream manifest(source.c_str());
+        if (!manifest.is_open())
+        {
+            fatal_err("Batch manifest '" + source + "' could not be opened.", 1);
+        }
+        string line;
+        while (getline(manifest, line))
+        {
+            if (!line.empty())
+            {
+                tasklists.push_back(line);
+            }
+        }
+    }
+
+    // Recipes are read once up front, then shared read-only by all runs
+    book.LoadAll();
+    book.Seal();
+
+    // Each run writes <tasklist>.output.csv and <tasklist>.perf.log
+    vector<int> time(tasklists.size()), dishes(tasklists.size());
+    vector<int> util(tasklists.size()), idle(tasklists.size());
+    vector<float> wait(tasklists.size());
+    vector<string> error(tasklists.size());
+    WorkPool pool(threads);
+    pool.Run(tasklists.size(), [&](int j)
+    {
+        // A tasklist that cannot be read fails its own run only
+        Scheduler core = proto;
+        if (read_tasklist(tasklists[j], book, core.GetOrders(), error[j]) != 0)
+        {
+            return;
+        }
+        filesystem::path base = tasklists[j];
+        base.replace_extension();
+        core.SetOutputFiles(base.string() + ".output.csv", base.string() + ".perf.log");
+        if (!proto.GetDishLog().empty())
+        {
+            core.SetDishLog(base.string() + ".dishes.csv");
+        }
+        if (!proto.GetStatsFile().empty())
+        {
+            core.SetStats(true, base.string() + ".stats.json");
+        }
+        PolicyRegistry::Get().Run(core);
+        time[j] = core.GetTime();
+        dishes[j] = core.GetOrders().size();
+        util[j] = core.GetStoveUtil();
+        idle[j] = core.GetStoveIdle();
+        wait[j] = core.GetWeightedWait();
+    });
+
+    // Gather metrics of all runs into one table
+    int failed = 0;
+    ofstream out(BATCHFILE, ofstream::out);
+    if (out.is_open())
+    {
+        out << "Tasklist, Dishes, Total Simulated Time, Stove Utilization Time, Stove Idle Time, Weighted Average Waiting Time, Error" << endl;
+        for (int j = 0; j < tasklists.size(); j++)
+        {
+            out << tasklists[j] << ", ";
+            if (!error[j].empty())
+            {
+                // Failed run: no metrics, and why in quotes (it has commas)
+                out << ", , , , , \"" << error[j] << "\"" << endl;
+                failed++;
+                continue;
+            }
+            out << dishes[j] << ", " << time[j] << ", ";
+            out << util[j] << ", " << idle[j] << ", " << wait[j] << ", " << endl;
+        }
+        out.close();
+    }
+    else
+    {
+        fatal_err("Batch summary file could not be opened.", 6);
+    }
+    cout << "Simulated " << tasklists.size() << " tasklists on " << pool.GetThreads() << " threads." << endl;
+    if (failed > 0)
+    {
+        cout << failed << " of them could not be read; see the Error column." << endl;
+    }
+    cout << "Summary written to " << BATCHFILE << endl;
+}
+
+/* run_tuner() - searches queue count, quantum table and boost interval
+ *               for the loaded tasklist, in parallel, and prints the best
+ *             - arguments are scheduler with dishes loaded & thread count
+ */
+void run_tuner(Scheduler &proto, int threads)
+{
+    // Candidates: the current parameters, then quantum tables growing
+    //  linearly from the top level down, for several queue counts
+    vector<SchedulerConfig> configs;
+    configs.push_back(proto.GetConfig());
+    int counts[] = {4, 6, 8, 10, 12, 16};
+    int bases[] = {1, 2, 3, 4};
+    int steps[] = {0, 1, 2, 3};
+    int boosts[] = {0, 60, 120, 240};
+    for (int c = 0; c < 6; c++)
+    {
+        for (int b = 0; b < 4; b++)
+        {
+            for (int s = 0; s < 4; s++)
+            {
+                for (int o = 0; o < 4; o++)
+                {
+                    SchedulerConfig config;
+                    config.SetQueueCount(counts[c]);
+                    vector<int> q;
+                    for (int d = 0; d < counts[c]; d++)
+                    {
+                        q.push_back(bases[b] + steps[s] * d);
+                    }
+                    config.SetQuanta(q);
+                    config.SetBoost(boosts[o]);
+                    config.SetPolicy(proto.GetConfig().GetPolicy());
+                    configs.push_back(config);
+                }
+            }
+        }
+    }
+
+    // Simulate every candidate without writing any files
+    vector<float> wait(configs.size());
+    vector<int> idle(configs.size());
+    WorkPool pool(threads);
+    pool.Run(configs.size(), [&](int j)
+    {
+        Scheduler core = proto;
+        core.SetConfig(configs[j]);
+        core.SetEventDriven(true);
+        core.SetOutputFiles("", "");
+        PolicyRegistry::Get().Run(core);
+        wait[j] = core.GetWeightedWait();
+        idle[j] = core.GetStoveIdle();
+    });
+
+    // Best = not beaten on both waiting time and stove idle time by any
+    //  other candidate; ties keep the earlier one
+    vector<int> best;
+    for (int j = 0; j < configs.size(); j++)
+    {
+        bool beaten = false;
+        for (int k = 0; k < configs.size() && !beaten; k++)
+        {
+            bool noWorse = wait[k] <= wait[j] && idle[k] <= idle[j];
+            bool better = wait[k] < wait[j] || idle[k] < idle[j];
+            beaten = noWorse && (better || k < j);
+        }
+        if (!beaten)
+        {
+            best.push_back(j);
+        }
+    }
+    sort(best.begin(), best.end(), [&](int a, int b) { return wait[a] < wait[b]; });
+
+    cout << "Tried " << configs.size() << " configurations on " << pool.GetThreads() << " threads." << endl;
+    cout << "Current   : wait " << wait[0] << ", idle " << idle[0] << ", " << configs[0].Describe() << endl;
+    for (int j = 0; j < best.size(); j++)
+    {
+        cout << "Best #" << left << setw(3) << j + 1 << ": wait " << wait[best[j]] << ", idle " << idle[best[j]];
+        cout << ", " << configs[best[j]].Describe() << endl;
+    }
+}
+
+/* run_montecarlo() - simulates the loaded tasklist many times with step
+ *                    and arrival times drawn from their distributions, in
+ *                    parallel, and reports confidence intervals
+ *                  - arguments are scheduler with dishes loaded, number of
+ *                    replications, seed, jitter of recipes without one &
+ *                    thread count
+ */
+void run_montecarlo(Scheduler &proto, int runs, unsigned long long seed, Spread &jitter, int threads)
+{
+    // The drawn orders replace these in every replication
+    vector<Order> orders;
+    orders.swap(proto.GetOrders());
+
+    // Every replication has a stream of its own, seeded from its number,
+    //  so results do not depend on the number of threads
+    vector<int> dishes(runs);
+    vector<double> time(runs), util(runs), weighted(runs), wait(runs), waitP95(runs), turnaround(runs), turnaroundP95(runs);
+    WorkPool pool(threads);
+    pool.Run(runs, [&](int r)
+    {
+        SpreadRng rng(spread_stream(seed, r));
+        Replica replica(orders, jitter, rng);
+        Scheduler core = proto;
+        core.GetOrders().swap(replica.GetOrders());
+        core.SetEventDriven(true);
+        core.SetOutputFiles("", "");
+        core.SetDishLog("");
+        core.SetStats(false);
+        PolicyRegistry::Get().Run(core);
+        TimeMetrics &m = core.GetMetrics().GetAll();
+        time[r] = core.GetTime();
+        dishes[r] = m.GetCount();
+        util[r] = (core.GetTime() > 0) ? (double)core.GetStoveUtil() / ((double)core.GetTime() * core.GetStoves()) : 0;
+        weighted[r] = core.GetWeightedWait();
+        wait[r] = m.GetWait();
+        waitP95[r] = m.GetWaitQ().Quantile(0.95);
+        turnaround[r] = m.GetTurnaround();
+        turnaroundP95[r] = m.GetTurnaroundQ().Quantile(0.95);
+    });
+
+    // One row per replication
+    ofstream out(MONTECARLOFILE, ofstream::out);
+    if (!out.is_open())
+    {
+        fatal_err("Monte Carlo results file could not be opened.", 6);
+    }
+    out << "Replication, Dishes, Total Simulated Time, Stove Utilization, Weighted Average Waiting Time, ";
+    out << "Average Waiting Time, Waiting Time p95, Average Turnaround Time, Turnaround p95" << endl;
+    for (int r = 0; r < runs; r++)
+    {
+        out << r + 1 << ", " << dishes[r] << ", " << time[r] << ", " << util[r] << ", " << weighted[r] << ", ";
+        out << wait[r] << ", " << waitP95[r] << ", " << turnaround[r] << ", " << turnaroundP95[r] << endl;
+    }
+    out.close();
+
+    // Mean with 95% confidence interval of each metric
+    const char *names[] = {"Total Simulated Time", "Stove Utilization", "Weighted Average Waiting Time",
+                           "Average Waiting Time", "Waiting Time p95", "Average Turnaround Time", "Turnaround p95"};
+    vector<double> *values[] = {&time, &util, &weighted, &wait, &waitP95, &turnaround, &turnaroundP95};
+    ostringstream summary;
+    summary << "Replications                  : " << runs << endl;
+    summary << "Seed                          : " << seed << endl;
+    for (int k = 0; k < 7; k++)
+    {
+        Estimate e;
+        for (int r = 0; r < runs; r++)
+        {
+            e.Add((*values[k])[r]);
+        }
+        summary << left << setw(30) << names[k] << ": " << e.Describe() << endl;
+    }
+    out.open(PERFLOGFILE, ofstream::out);
+    if (!out.is_open())
+    {
+        fatal_err("Performance log file could not be opened.\nThe simulation still went through, but metrics were not recorded.", 6);
+    }
+    out << "Monte Carlo Performance Log" << endl << summary.str();
+    out.close();
+    cout << "Simulated " << runs << " replications on " << pool.GetThreads() << " threads." << endl;
+    cout << summary.str();
+    cout << "Replications written to " << MONTECARLOFILE << endl;
+}
+
+/* parse_list() - parses a comma-separated list of numbers, e.g. "2,3,4"
+ *              - returns the numbers (empty if there are none)
+ */
+vector<int> parse_list(const string &s)
+{
+    vector<int> list;
+    stringstream in(s);
+    string item;
+    while (getline(in, item, ','))
+    {
+        list.push_back(atoi(item.c_str()));
+    }
+    return list;
+}
@@ -6,4 +6,30 @@
 #include <cstdlib>
 #include <string>
 #include <algorithm>
+#include <set>
+#include <map>
+#include <deque>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
 #include "dish.cpp"
+#include "dishtable.cpp"
+#include "kernel.cpp"
+#include "mfq.cpp"
+#include "config.cpp"
+#include "policy.cpp"
+#include "stove.cpp"
+#include "recipe.cpp"
+#include "workpool.cpp"
+#include "event.cpp"
+#include "rowwriter.cpp"
+#include "textfile.cpp"
+#include "trace.cpp"
+#include "stats.cpp"
+#include "metrics.cpp"
+#include "snapshot.cpp"
+#include "asyncout.cpp"
+#include "nodepool.cpp"
+#include "life.cpp"
+#include "online.cpp"
+#include "montecarlo.cpp"
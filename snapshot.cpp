@@ -0,0 +1,176 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <cstring>
+#include <cstdio>
+#include <type_traits>
+#include <filesystem>
+
+#define SNAPSHOT_MAGIC "MPSN" // first bytes of every snapshot file
+#define SNAPSHOT_VERSION 5
+
+using namespace std;
+
+/*
+ * Snapshot - a binary snapshot of a simulation, being either written or
+ *            read.
+ *
+ * Every part of the state has one Snap(s) member that passes each of its
+ * fields to Field(), in a fixed order. Writing appends the fields to the
+ * file, reading fills them back in, so the two can never get out of step.
+ * Numbers are stored as they are in memory: a snapshot is only meant to be
+ * read by the same build on the same kind of machine.
+ *
+ * A snapshot being written goes to '<file>.tmp' first and replaces the
+ * file only once complete, so a run killed halfway through leaves the
+ * previous snapshot intact.
+ */
+class Snapshot
+{
+public:
+    Snapshot(const string &filename, bool loading)
+    {
+        _filename = filename;
+        _loading = loading;
+        _pos = 0;
+        _good = true;
+        if (!_loading)
+        {
+            _data.insert(_data.end(), SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + 4);
+            _data.push_back(SNAPSHOT_VERSION);
+            return;
+        }
+        ifstream in(filename.c_str(), ios::in | ios::binary);
+        _good = in.is_open();
+        if (_good)
+        {
+            _data.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+            _good = _data.size() >= 5 && string(&_data[0], 4) == SNAPSHOT_MAGIC && _data[4] == SNAPSHOT_VERSION;
+            _pos = 5;
+        }
+    }
+    bool IsLoading() // returns true if reading a snapshot back
+    {
+        return _loading;
+    }
+    bool IsGood() // returns true if nothing was missing so far (reading only)
+    {
+        return _good;
+    }
+    template <class T>
+    void Field(T &x) // a plain value (number, enum, or struct of them)
+    {
+        static_assert(is_trivially_copyable<T>::value, "only plain values are stored as they are");
+        Bytes(&x, sizeof(T));
+    }
+    template <class T>
+    void Field(vector<T> &v)
+    {
+        long long n = v.size();
+        Field(n);
+        if (_loading)
+        {
+            if (!Fits(n, sizeof(T)))
+            {
+                return;
+            }
+            v.assign(n, T());
+        }
+        if (n > 0)
+        {
+            Bytes(&v[0], n * sizeof(T));
+        }
+    }
+    void Field(vector<bool> &v)
+    {
+        vector<char> c(v.begin(), v.end());
+        Field(c);
+        v.assign(c.begin(), c.end());
+    }
+    template <class T>
+    void Field(deque<T> &q)
+    {
+        vector<T> v(q.begin(), q.end());
+        Field(v);
+        q.assign(v.begin(), v.end());
+    }
+    template <class T, class C, class A>
+    void Field(set<T, C, A> &q)
+    {
+        vector<T> v(q.begin(), q.end());
+        Field(v);
+        q = set<T, C, A>(v.begin(), v.end());
+    }
+    void Field(string &str)
+    {
+        vector<char> c(str.begin(), str.end());
+        Field(c);
+        str.assign(c.begin(), c.end());
+    }
+    bool Close() // write the snapshot out in one go; returns false if that failed
+    {
+        if (_loading)
+        {
+            return _good;
+        }
+        string tmp = _filename + ".tmp";
+        ofstream out(tmp.c_str(), ios::out | ios::binary);
+        if (!out.is_open() || !out.write(&_data[0], _data.size()))
+        {
+            return false;
+        }
+        out.close();
+        return !out.fail() && rename(tmp.c_str(), _filename.c_str()) == 0;
+    }
+private:
+    void Bytes(void *p, size_t size) // copy size bytes at p to or from the snapshot
+    {
+        if (!_loading)
+        {
+            _data.insert(_data.end(), (char *)p, (char *)p + size);
+        }
+        else if (_good && Fits(1, size))
+        {
+            memcpy(p, &_data[_pos], size);
+            _pos += size;
+        }
+    }
+    bool Fits(long long n, size_t size) // returns true if n values of size bytes are left to read
+    {
+        _good = _good && n >= 0 && (unsigned long long)n * size <= _data.size() - _pos;
+        return _good;
+    }
+    string _filename;
+    bool _loading;
+    vector<char> _data; // the whole snapshot
+    size_t _pos; // where the next field is read from
+    bool _good;
+};
+
+/* reopen_at() - opens a file written by an earlier run so as to go on
+ *               after its first 'size' bytes (all that a snapshot knows
+ *               of); the rest is cut off
+ *             - returns true if so, false if the file is missing or too
+ *               short (or size is -1) and was started over instead
+ */
+bool reopen_at(ofstream &out, const string &filename, long long size)
+{
+    error_code ec;
+    if (size >= 0 && filesystem::exists(filename, ec) && filesystem::file_size(filename, ec) >= size)
+    {
+        filesystem::resize_file(filename, size, ec);
+        out.open(filename.c_str(), ios::in | ios::out);
+        out.seekp(0, ios::end);
+        if (!ec && out.is_open())
+        {
+            return true;
+        }
+        out.close();
+    }
+    out.open(filename.c_str(), ofstream::out);
+    return false;
+}
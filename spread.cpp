@@ -0,0 +1,192 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <random>
+#include <charconv>
+#include <cmath>
+
+using namespace std;
+
+// Kinds of distribution a time can be drawn from
+//  SP_FIXED      - no spread, always the time itself
+//  SP_NORMAL     - normal around the time, with standard deviation a
+//  SP_UNIFORM    - uniform between a and b
+//  SP_EXP        - exponential with mean a (the time itself if a is 0)
+//  SP_LOGNORMAL  - the time times a lognormal factor of mean 1, with
+//                  shape (standard deviation of its log) a
+//  SP_TRIANGULAR - triangular between a and b, peaking at the time (kept
+//                  between a and b)
+enum spread_kind {SP_FIXED, SP_NORMAL, SP_UNIFORM, SP_EXP, SP_LOGNORMAL, SP_TRIANGULAR};
+
+typedef mt19937_64 SpreadRng; // random number stream of one Monte Carlo replication
+
+/* spread_stream() - returns the seed of stream r of a run seeded with
+ *                   'seed', so that every stream is different however
+ *                   close the seeds are (SplitMix64)
+ */
+inline unsigned long long spread_stream(unsigned long long seed, unsigned long long r)
+{
+    unsigned long long z = seed + (r + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * Spread - how a time (a step of a recipe or an arrival) varies from run to
+ *          run, e.g. "normal 5" or "uniform 25 40".
+ *
+ * Values are drawn from the raw bits of the stream rather than with the
+ * <random> distributions, whose results differ between standard libraries,
+ * so a seed gives the same draws with any compiler.
+ */
+class Spread
+{
+public:
+    Spread()
+    {
+        _kind = SP_FIXED;
+        _a = 0;
+        _b = 0;
+    }
+    bool IsFixed() const // returns true if there is no spread
+    {
+        return _kind == SP_FIXED;
+    }
+    /* Parse() - reads a distribution, e.g. "normal 5" (words and numbers
+     *           separated by spaces; "" for none)
+     *         - returns true if successful
+     */
+    bool Parse(string_view text)
+    {
+        string_view word = Token(text);
+        double p[2];
+        int n = 0;
+        for (string_view t = Token(text); !t.empty(); t = Token(text))
+        {
+            if (n == 2)
+            {
+                return false;
+            }
+            from_chars_result r = from_chars(t.data(), t.data() + t.size(), p[n]);
+            if (r.ec != errc() || r.ptr != t.data() + t.size() || !isfinite(p[n]))
+            {
+                return false;
+            }
+            n++;
+        }
+        _a = (n > 0) ? p[0] : 0;
+        _b = (n > 1) ? p[1] : 0;
+        if (word.empty())
+        {
+            _kind = SP_FIXED;
+            return true;
+        }
+        else if (word == "normal" && n == 1 && _a >= 0)
+        {
+            _kind = SP_NORMAL;
+        }
+        else if (word == "uniform" && n == 2 && _a <= _b)
+        {
+            _kind = SP_UNIFORM;
+        }
+        else if (word == "exp" && n <= 1 && _a >= 0)
+        {
+            _kind = SP_EXP;
+        }
+        else if (word == "lognormal" && n == 1 && _a >= 0)
+        {
+            _kind = SP_LOGNORMAL;
+        }
+        else if (word == "triangular" && n == 2 && _a <= _b)
+        {
+            _kind = SP_TRIANGULAR;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+    /* Sample() - draws a step time; base is the time in the recipe
+     *          - returns the time, at least 1 "second" if drawn
+     */
+    int Sample(int base, SpreadRng &rng)
+    {
+        if (_kind == SP_FIXED)
+        {
+            return base;
+        }
+        return max(1, (int)lround(Draw(base, rng)));
+    }
+    /* Offset() - draws how many "seconds" late (or early, if negative) an
+     *            order arrives
+     */
+    int Offset(SpreadRng &rng)
+    {
+        return (_kind == SP_FIXED) ? 0 : (int)lround(Draw(0, rng));
+    }
+private:
+    /* Token() - returns the next word of text (after spaces) and drops it
+     *           from text; "" at the end
+     */
+    static string_view Token(string_view &text)
+    {
+        size_t x = text.find_first_not_of(" \t");
+        if (x == string_view::npos)
+        {
+            text = string_view();
+            return text;
+        }
+        size_t y = min(text.find_first_of(" \t", x), text.size());
+        string_view t = text.substr(x, y - x);
+        text.remove_prefix(y);
+        return t;
+    }
+    double Draw(double base, SpreadRng &rng) // a value of the distribution around base
+    {
+        switch (_kind)
+        {
+        case SP_NORMAL:
+            return base + _a * Normal(rng);
+        case SP_UNIFORM:
+            return _a + (_b - _a) * Uniform(rng);
+        case SP_EXP:
+            return -((_a > 0) ? _a : base) * log(1 - Uniform(rng));
+        case SP_LOGNORMAL:
+            return base * exp(_a * Normal(rng) - _a * _a / 2);
+        case SP_TRIANGULAR:
+        {
+            // Inverse of the distribution function
+            double c = min(max(base, _a), _b);
+            double u = Uniform(rng);
+            double w = _b - _a;
+            if (w <= 0)
+            {
+                return _a;
+            }
+            if (u < (c - _a) / w)
+            {
+                return _a + sqrt(u * w * (c - _a));
+            }
+            return _b - sqrt((1 - u) * w * (_b - c));
+        }
+        default:
+            return base;
+        }
+    }
+    static double Uniform(SpreadRng &rng) // uniform in [0, 1), from 53 bits
+    {
+        return (rng() >> 11) * (1.0 / 9007199254740992.0);
+    }
+    static double Normal(SpreadRng &rng) // standard normal (Box-Muller)
+    {
+        double u = 1 - Uniform(rng); // (0, 1], so the log is finite
+        double v = Uniform(rng);
+        return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+    }
+    spread_kind _kind;
+    double _a; // parameters, see spread_kind
+    double _b;
+};
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define STATS_TSC // phases are timed with the time stamp counter
+#define STATS_UNIT "cycles"
+#else
+#define STATS_UNIT "ns"
+#endif
+#include "trace.cpp"
+#include "snapshot.cpp"
+
+#define STATS_BUCKETS 20 // queue length buckets: 0, 1, 2-3, 4-7, ..., 2^18 and up
+
+using namespace std;
+
+// Parts of Proceed() that are timed
+//  PH_ARRIVE   - priority boost and arrivals
+//  PH_SCHEDULE - Schedule(), i.e. the policy picking dishes
+//  PH_STOVE    - the rest of the stove state machine (cleaning, preheating)
+//  PH_OUTPUT   - formatting the row for output.csv
+//  PH_TASKS    - stepping the dishes and their state changes
+enum stat_phase {PH_ARRIVE, PH_SCHEDULE, PH_STOVE, PH_OUTPUT, PH_TASKS, PH_COUNT};
+
+/* stat_clock() - reads the time stamp counter (nanoseconds where there
+ *                is none)
+ */
+inline unsigned long long stat_clock()
+{
+    #ifdef STATS_TSC
+    return __rdtsc();
+    #else
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    #endif
+}
+
+/*
+ * SimStats - counters on the hot path of a simulation, for finding out
+ *            where the time goes. Off unless turned on; when off, every
+ *            call returns right away.
+ */
+class SimStats
+{
+public:
+    SimStats()
+    {
+        _on = false;
+        _ticks = 0;
+        for (int p = 0; p < PH_COUNT; p++)
+        {
+            _spent[p] = 0;
+        }
+        for (int k = 0; k <= TR_END; k++)
+        {
+            _kinds[k] = 0;
+        }
+    }
+    bool IsOn() // returns true if counting
+    {
+        return _on;
+    }
+    void SetOn(bool on) // turn counting on or off (before Sim() only)
+    {
+        _on = on;
+    }
+    unsigned long long Start() // clock reading at the start of a "second"
+    {
+        if (!_on)
+        {
+            return 0;
+        }
+        _ticks++;
+        return stat_clock();
+    }
+    void Phase(stat_phase p, unsigned long long &mark) // phase p ran since mark; mark is now
+    {
+        if (!_on)
+        {
+            return;
+        }
+        unsigned long long now = stat_clock();
+        _spent[p] += now - mark;
+        mark = now;
+    }
+    void Count(trace_kind kind, int dish) // something happened to dish (see trace.cpp)
+    {
+        // A stove left empty is not a dispatch
+        if (_on && (kind != TR_STOVE || dish > -1))
+        {
+            _kinds[kind]++;
+        }
+    }
+    void Sample(int level, int length, int weight = 1) // queue 'level' held 'length' dishes for 'weight' "seconds"
+    {
+        if (!_on)
+        {
+            return;
+        }
+        if (level >= _histogram.size())
+        {
+            _histogram.resize(level + 1, vector<long long>(STATS_BUCKETS, 0));
+        }
+        int b = (length == 0) ? 0 : 32 - __builtin_clz(length);
+        _histogram[level][min(b, STATS_BUCKETS - 1)] += weight;
+    }
+    void Write(ostream &out) // add the counters to a performance log
+    {
+        unsigned long long total = 0;
+        for (int p = 0; p < PH_COUNT; p++)
+        {
+            total += _spent[p];
+        }
+        out << "Timed Seconds                 : " << _ticks << endl;
+        for (int p = 0; p < PH_COUNT; p++)
+        {
+            out << left << setw(30) << PhaseName(p) + " (" STATS_UNIT ")" << ": " << _spent[p];
+            out << " (" << fixed << setprecision(1) << (total ? 100.0 * _spent[p] / total : 0.0) << "%)" << endl;
+            out.unsetf(ios::floatfield);
+        }
+        out << "Dispatches                    : " << _kinds[TR_STOVE] << endl;
+        out << "Preemptions                   : " << _kinds[TR_PREEMPT] << endl;
+        out << "Promotions                    : " << _kinds[TR_PROMOTE] << endl;
+        out << "Demotions                     : " << _kinds[TR_DEMOTE] << endl;
+        // Seconds per queue length, top level first
+        for (int level = _histogram.size() - 1; level >= 0; level--)
+        {
+            out << "Queue " << left << setw(24) << to_string(level + 1) + " Lengths" << ":";
+            for (int b = 0; b < STATS_BUCKETS; b++)
+            {
+                if (_histogram[level][b] > 0)
+                {
+                    out << " " << BucketName(b) << "=" << _histogram[level][b];
+                }
+            }
+            out << endl;
+        }
+    }
+    void WriteJson(ostream &out) // write the counters as a JSON object
+    {
+        out << "{" << endl;
+        out << "  \"unit\": \"" STATS_UNIT "\"," << endl;
+        out << "  \"seconds\": " << _ticks << "," << endl;
+        out << "  \"phases\": {";
+        for (int p = 0; p < PH_COUNT; p++)
+        {
+            out << (p ? ", " : "") << "\"" << PhaseKey(p) << "\": " << _spent[p];
+        }
+        out << "}," << endl;
+        out << "  \"dispatches\": " << _kinds[TR_STOVE] << "," << endl;
+        out << "  \"preemptions\": " << _kinds[TR_PREEMPT] << "," << endl;
+        out << "  \"promotions\": " << _kinds[TR_PROMOTE] << "," << endl;
+        out << "  \"demotions\": " << _kinds[TR_DEMOTE] << "," << endl;
+        // One histogram per level, bottom level first; bucket b counts
+        //  "seconds" with 2^(b-1) up to 2^b - 1 dishes in line (b = 0: none)
+        out << "  \"queue_lengths\": [";
+        for (int level = 0; level < _histogram.size(); level++)
+        {
+            out << (level ? ", " : "") << "[";
+            for (int b = 0; b < STATS_BUCKETS; b++)
+            {
+                out << (b ? ", " : "") << _histogram[level][b];
+            }
+            out << "]";
+        }
+        out << "]" << endl;
+        out << "}" << endl;
+    }
+    void Merge(SimStats &o) // add the counters of o (another stretch of time)
+    {
+        _ticks += o._ticks;
+        for (int p = 0; p < PH_COUNT; p++)
+        {
+            _spent[p] += o._spent[p];
+        }
+        for (int k = 0; k <= TR_END; k++)
+        {
+            _kinds[k] += o._kinds[k];
+        }
+        if (o._histogram.size() > _histogram.size())
+        {
+            _histogram.resize(o._histogram.size(), vector<long long>(STATS_BUCKETS, 0));
+        }
+        for (int level = 0; level < o._histogram.size(); level++)
+        {
+            for (int b = 0; b < STATS_BUCKETS; b++)
+            {
+                _histogram[level][b] += o._histogram[level][b];
+            }
+        }
+    }
+    void Snap(Snapshot &s) // save or restore the counters
+    {
+        s.Field(_ticks);
+        s.Field(_spent);
+        s.Field(_kinds);
+        long long levels = _histogram.size();
+        s.Field(levels);
+        _histogram.resize((s.IsGood() && levels >= 0) ? levels : 0);
+        for (int level = 0; level < _histogram.size(); level++)
+        {
+            s.Field(_histogram[level]);
+        }
+    }
+private:
+    string PhaseName(int p) // name of phase p in the performance log
+    {
+        const char *names[] = {"Arrivals", "Schedule()", "Stoves", "Output", "Tasks"};
+        return names[p];
+    }
+    string PhaseKey(int p) // name of phase p in JSON
+    {
+        const char *keys[] = {"arrivals", "schedule", "stoves", "output", "tasks"};
+        return keys[p];
+    }
+    string BucketName(int b) // range of queue lengths in bucket b, e.g. "4-7"
+    {
+        if (b < 2)
+        {
+            return to_string(b);
+        }
+        string from = to_string(1 << (b - 1));
+        return (b == STATS_BUCKETS - 1) ? from + "+" : from + "-" + to_string((1 << b) - 1);
+    }
+    bool _on;
+    long long _ticks; // "seconds" timed
+    unsigned long long _spent[PH_COUNT]; // clock ticks per phase
+    long long _kinds[TR_END + 1]; // events by trace kind
+    vector<vector<long long> > _histogram; // "seconds" per level and length bucket
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <string>
+#include <sstream>
+
+#define STOVE_DIRTY 0
+#define STOVE_CLEAN 2
+#define STOVE_SWITCH (STOVE_CLEAN - STOVE_DIRTY) // "seconds" lost when a stove switches dishes
+
+using namespace std;
+
+/* stove_name() - returns name of stove s as used in output
+ *              - arguments are index of stove & number of stoves
+ */
+string stove_name(int s, int stoves)
+{
+    if (stoves == 1)
+    {
+        return "Stove";
+    }
+    ostringstream name;
+    name << "Stove " << s + 1;
+    return name.str();
+}
+
+class Stove
+{
+public:
+    /*
+     * Constructor
+     */
+    Stove()
+    {
+        _dish = -1; // Nothing is on the stove
+        _status = STOVE_CLEAN - 1; // Needs preheating before first use
+        _util = 0;
+        _quantum = 1; // By default, interrupt every 1 "second"
+        _last = -1; // Nothing cooked yet
+        _switches = 0;
+        _lost = 0;
+    }
+
+    int GetDish() // getter for index of dish on stove (-1 if none)
+    {
+        return _dish;
+    }
+    void SetDish(int d) // setter for index of dish on stove
+    {
+        _dish = d;
+        if (d > -1)
+        {
+            _last = d;
+        }
+    }
+    int GetLast() // getter for index of dish cooked last (-1 if none)
+    {
+        return _last;
+    }
+    int GetStatus() // getter for status (STOVE_DIRTY up to STOVE_CLEAN)
+    {
+        return _status;
+    }
+    void SetStatus(int s) // setter for status
+    {
+        _status = s;
+    }
+    int GetUtil() // getter for utilization time
+    {
+        return _util;
+    }
+    void Use(int n) // add n "seconds" of utilization time
+    {
+        _util += n;
+    }
+    int GetQuantum() // getter for time left in current quantum
+    {
+        return _quantum;
+    }
+    void SetQuantum(int q) // setter for time quantum
+    {
+        _quantum = q;
+    }
+    int GetSwitches() // getter for number of times the stove was cleaned for another dish
+    {
+        return _switches;
+    }
+    void CountSwitch() // the stove starts getting cleaned for another dish
+    {
+        _switches++;
+    }
+    int GetLost() // getter for "seconds" spent cleaning and preheating
+    {
+        return _lost;
+    }
+    void CountLost() // one more "second" spent cleaning or preheating
+    {
+        _lost++;
+    }
+    void Merge(Stove &o) // add the counters of o (the same stove over another stretch of time)
+    {
+        _util += o._util;
+        _switches += o._switches;
+        _lost += o._lost;
+    }
+private:
+    int _dish; // Index in _dishes of Dish currently on this stove
+    int _status; // Stove status (from DIRTY to CLEAN, with 1 step in between)
+    int _util; // stove utilization time
+    int _quantum; // Current time quantum
+    int _last; // Index in _dishes of Dish cooked last
+    int _switches; // Times cleaning started
+    int _lost; // "Seconds" spent cleaning and preheating
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <sstream>
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/*
+ * MappedFile - read-only view of a whole input file.
+ *
+ * The file is memory-mapped where the OS allows it, so parsing works
+ * straight off the page cache without copying lines into strings.
+ */
+class MappedFile
+{
+public:
+    MappedFile(const string &filename)
+    {
+        _data = NULL;
+        _size = 0;
+        _open = false;
+        #ifdef _WIN32
+        ifstream in(filename.c_str(), ios::binary);
+        if (in.is_open())
+        {
+            ostringstream all;
+            all << in.rdbuf();
+            _copy = all.str();
+            _data = _copy.data();
+            _size = _copy.size();
+            _open = true;
+        }
+        #else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd > -1)
+        {
+            struct stat st;
+            if (fstat(fd, &st) == 0)
+            {
+                _open = true;
+                _size = st.st_size;
+                if (_size > 0)
+                {
+                    void *p = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    _data = (p == MAP_FAILED) ? NULL : (const char *)p;
+                    _open = (_data != NULL);
+                }
+            }
+            close(fd);
+        }
+        #endif
+    }
+    ~MappedFile()
+    {
+        #ifndef _WIN32
+        if (_data != NULL)
+        {
+            munmap((void *)_data, _size);
+        }
+        #endif
+    }
+    bool IsOpen() // returns true if the file could be read
+    {
+        return _open;
+    }
+    string_view GetText() // getter for whole file contents
+    {
+        return string_view(_data, _size);
+    }
+private:
+    MappedFile(const MappedFile &); // not copyable
+    MappedFile& operator = (const MappedFile &);
+    const char *_data;
+    size_t _size;
+    bool _open;
+    #ifdef _WIN32
+    string _copy;
+    #endif
+};
+
+/*
+ * LineReader - splits text into lines and parses fields in them, keeping
+ *              track of row and column for error messages.
+ */
+class LineReader
+{
+public:
+    LineReader(string_view text)
+    {
+        _text = text;
+        _pos = 0;
+        _row = 0;
+    }
+    bool Next(string_view &line) // get next line (without '\r\n'), false at end of text
+    {
+        if (_pos >= _text.size())
+        {
+            return false;
+        }
+        size_t end = _text.find('\n', _pos);
+        if (end == string_view::npos)
+        {
+            end = _text.size();
+        }
+        line = _text.substr(_pos, end - _pos);
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        _pos = end + 1;
+        _row++;
+        return true;
+    }
+    int GetRow() // getter for number of current line, from 1
+    {
+        return _row;
+    }
+    string Where(int column) // position for error messages, e.g. "line 3, column 8"
+    {
+        ostringstream out;
+        out << "line " << _row << ", column " << column;
+        return out.str();
+    }
+    /* ParseInt() - parses a whole number from line[x] on, skipping spaces
+     *              before it; only spaces may follow it
+     *            - returns true if successful, with number in n and x at
+     *              the column (from 1) where the number starts
+     */
+    static bool ParseInt(string_view line, size_t &x, int &n)
+    {
+        while (x < line.size() && line[x] == ' ')
+        {
+            x++;
+        }
+        const char *first = line.data() + x;
+        const char *last = line.data() + line.size();
+        from_chars_result r = from_chars(first, last, n);
+        x++; // columns count from 1
+        if (r.ec != errc() || r.ptr == first)
+        {
+            return false;
+        }
+        for (const char *p = r.ptr; p < last; p++)
+        {
+            if (*p != ' ' && *p != '\t')
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+private:
+    string_view _text;
+    size_t _pos; // offset of start of next line
+    int _row; // number of current line
+};
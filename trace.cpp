@@ -0,0 +1,271 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include "dish.cpp"
+
+#define TRACE_MAGIC "MPTR" // first bytes of every trace file
+#define TRACE_VERSION 1
+#define TRACE_BUFFER 65536 // bytes collected before each write to the file
+
+using namespace std;
+
+// What a trace record says happened
+//  TR_ARRIVE  - dish arrives (a = type, b = time of its first task)
+//  TR_STATE   - dish changes state (a = new dish_state)
+//  TR_TASK    - dish starts its next task (a = type, b = time)
+//  TR_STOVE   - dish is put on stove a (dish -1: stove left empty)
+//  TR_PREEMPT - dish is taken off stove a while it could still cook
+//  TR_PROMOTE - dish moves up to queue level a
+//  TR_DEMOTE  - dish moves down to queue level a
+//  TR_CLEAN   - stove a is being cleaned
+//  TR_PREHEAT - stove a is being preheated
+//  TR_BOOST   - every queued dish goes back to the top level
+//  TR_END     - simulation over (time of record is the last "second")
+enum trace_kind {TR_ARRIVE, TR_STATE, TR_TASK, TR_STOVE, TR_PREEMPT, TR_PROMOTE,
+    TR_DEMOTE, TR_CLEAN, TR_PREHEAT, TR_BOOST, TR_END};
+
+class TraceRecord
+{
+public:
+    TraceRecord()
+    {
+        _kind = TR_END;
+        _time = 0;
+        _late = false;
+        _dish = -1;
+        _a = 0;
+        _b = 0;
+    }
+    trace_kind GetKind() const // getter for kind
+    {
+        return _kind;
+    }
+    int GetTime() const // getter for "second" of record
+    {
+        return _time;
+    }
+    bool IsLate() const // returns true if it happened after that "second"'s row was taken
+    {
+        return _late;
+    }
+    int GetDish() const // getter for dish index (-1 if none)
+    {
+        return _dish;
+    }
+    int GetA() const // getter for first argument
+    {
+        return _a;
+    }
+    int GetB() const // getter for second argument
+    {
+        return _b;
+    }
+private:
+    friend class TraceReader;
+    trace_kind _kind;
+    int _time;
+    bool _late;
+    int _dish;
+    int _a;
+    int _b;
+};
+
+/*
+ * TraceWriter - writes the compact binary trace of a simulation.
+ *
+ * Only transitions are recorded, never the per-"second" rows. A file is
+ * the magic, the version, the number of stoves, the dish names (each
+ * distinct name once) and the name of every dish, followed by records.
+ * A record is a kind byte and four unsigned LEB128 numbers: clock ticks
+ * since the previous record (two per "second", the odd one for what
+ * happens after the row is taken), dish index + 1, a and b.
+ */
+class TraceWriter
+{
+public:
+    TraceWriter(const string &filename) : _out(filename.c_str(), ios::out | ios::binary)
+    {
+        _clock = 0;
+        _last = 0;
+        _buffer.reserve(TRACE_BUFFER + 64);
+    }
+    ~TraceWriter()
+    {
+        Flush();
+    }
+    bool IsOpen() // returns true if the trace file could be created
+    {
+        return _out.is_open();
+    }
+    void Begin(int stoves, vector<Order> &dishes) // write the header
+    {
+        _buffer.insert(_buffer.end(), TRACE_MAGIC, TRACE_MAGIC + 4);
+        _buffer.push_back(TRACE_VERSION);
+        Put(stoves);
+        // Dish names are interned, one entry per recipe
+        map<Recipe *, int> ids;
+        vector<int> nameOf;
+        for (int i = 0; i < dishes.size(); i++)
+        {
+            map<Recipe *, int>::iterator it = ids.find(dishes[i].GetRecipe());
+            if (it == ids.end())
+            {
+                it = ids.insert(make_pair(dishes[i].GetRecipe(), (int)ids.size())).first;
+            }
+            nameOf.push_back(it->second);
+        }
+        vector<string> names(ids.size());
+        for (map<Recipe *, int>::iterator it = ids.begin(); it != ids.end(); ++it)
+        {
+            names[it->second] = it->first->GetName();
+        }
+        Put(names.size());
+        for (int n = 0; n < names.size(); n++)
+        {
+            Put(names[n].size());
+            _buffer.insert(_buffer.end(), names[n].begin(), names[n].end());
+        }
+        Put(nameOf.size());
+        for (int i = 0; i < nameOf.size(); i++)
+        {
+            Put(nameOf[i]);
+        }
+    }
+    void SetClock(int time, bool late) // "second" of the records that follow
+    {
+        _clock = 2 * time + (late ? 1 : 0);
+    }
+    void Record(trace_kind kind, int dish, int a = 0, int b = 0) // add one record
+    {
+        _buffer.push_back(kind);
+        Put(_clock - _last);
+        Put(dish + 1);
+        Put(a);
+        Put(b);
+        _last = _clock;
+        if (_buffer.size() >= TRACE_BUFFER)
+        {
+            Flush();
+        }
+    }
+    void End(int time) // write the final record and everything still buffered
+    {
+        SetClock(time, false);
+        Record(TR_END, -1);
+        Flush();
+        _out.close();
+    }
+private:
+    void Put(unsigned long long v) // append v as unsigned LEB128
+    {
+        while (v >= 0x80)
+        {
+            _buffer.push_back((char)(v | 0x80));
+            v >>= 7;
+        }
+        _buffer.push_back((char)v);
+    }
+    void Flush()
+    {
+        if (!_buffer.empty() && _out.is_open())
+        {
+            _out.write(&_buffer[0], _buffer.size());
+        }
+        _buffer.clear();
+    }
+    ofstream _out;
+    vector<char> _buffer; // records not yet written to the file
+    long long _clock; // clock of the records being added
+    long long _last; // clock of the previous record
+};
+
+/*
+ * TraceReader - reads back a file written by TraceWriter.
+ */
+class TraceReader
+{
+public:
+    TraceReader(const string &filename) : _in(filename.c_str(), ios::in | ios::binary)
+    {
+        _stoves = 0;
+        _clock = 0;
+        _good = false;
+        char magic[5] = {0};
+        if (!_in.read(magic, 5) || string(magic, 4) != TRACE_MAGIC || magic[4] != TRACE_VERSION)
+        {
+            return;
+        }
+        _stoves = Get();
+        int n = Get();
+        for (int k = 0; k < n && _in; k++)
+        {
+            string name(Get(), ' ');
+            _in.read(&name[0], name.size());
+            _names.push_back(name);
+        }
+        n = Get();
+        for (int i = 0; i < n && _in; i++)
+        {
+            _nameOf.push_back(Get());
+        }
+        _good = (bool)_in;
+    }
+    bool IsGood() // returns true if the file is a readable trace
+    {
+        return _good;
+    }
+    int GetStoves() // getter for number of stoves
+    {
+        return _stoves;
+    }
+    int GetDishCount() // getter for number of dishes
+    {
+        return _nameOf.size();
+    }
+    string GetName(int i) // getter for name of dish i
+    {
+        return _names.at(_nameOf.at(i));
+    }
+    bool Next(TraceRecord &r) // read the next record, false at end of file
+    {
+        int kind = _in.get();
+        if (kind == EOF || kind > TR_END)
+        {
+            return false;
+        }
+        _clock += Get();
+        r._kind = (trace_kind)kind;
+        r._time = _clock / 2;
+        r._late = (_clock % 2 == 1);
+        r._dish = (int)Get() - 1;
+        r._a = Get();
+        r._b = Get();
+        return (bool)_in;
+    }
+private:
+    unsigned long long Get() // read an unsigned LEB128 number
+    {
+        unsigned long long v = 0;
+        int shift = 0;
+        int c;
+        while ((c = _in.get()) != EOF)
+        {
+            v |= (unsigned long long)(c & 0x7f) << shift;
+            if ((c & 0x80) == 0)
+            {
+                break;
+            }
+            shift += 7;
+        }
+        return v;
+    }
+    ifstream _in;
+    int _stoves;
+    vector<string> _names; // distinct dish names
+    vector<int> _nameOf; // index in _names of each dish's name
+    long long _clock;
+    bool _good;
+};
@@ -0,0 +1,266 @@
+/*
+ * trace2csv - turns a binary trace (scheduler --trace) back into the
+ *             output.csv layout
+ *
+ * Usage: trace2csv TRACE [OUTPUT] [--collapse]
+ *        OUTPUT defaults to output.csv
+ */
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <deque>
+#include <set>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include "dish.cpp"
+#include "stove.cpp"
+#include "rowwriter.cpp"
+#include "trace.cpp"
+
+using namespace std;
+
+void fatal_err(const string &s, int code)
+{
+    cout << "FATAL ERR: " << s << endl;
+    cout << "The error code is " << code << " in case you need it." << endl;
+    exit(code);
+}
+
+/*
+ * Replay - what the scheduler showed at each "second", rebuilt from the
+ *          transitions in a trace.
+ */
+class Replay
+{
+public:
+    Replay(TraceReader &trace) : _trace(trace)
+    {
+        int n = trace.GetDishCount();
+        _tasks.assign(n, Task(COOK, 0));
+        _states.assign(n, NOTARRIVED);
+        _stoves.assign(trace.GetStoves(), -1);
+    }
+    void Run(ostream &out, bool collapse) // write the whole schedule to out
+    {
+        out << "Time, ";
+        for (int s = 0; s < _stoves.size(); s++)
+        {
+            out << stove_name(s, _stoves.size()) << ", ";
+        }
+        out << "Ready, Assistants, Remarks" << endl;
+
+        RowWriter rows(out, collapse);
+        TraceRecord r;
+        bool more = _trace.Next(r);
+        int time = 1;
+        // Rows run up to the "second" before the final record
+        while (more && !(r.GetKind() == TR_END && r.GetTime() <= time))
+        {
+            // Everything up to the row of this "second"
+            string remarks;
+            for (; more && r.GetKind() != TR_END && r.GetTime() <= time && !(r.GetTime() == time && r.IsLate()); more = _trace.Next(r))
+            {
+                Apply(r, remarks);
+            }
+            string columns = Columns();
+            // Dishes on a stove or with an assistant get one "second" of work
+            //  (in between events, the dish on a stove is not marked ONSTOVE)
+            for (int s = 0; s < _stoves.size(); s++)
+            {
+                if (_stoves[s] > -1)
+                {
+                    _tasks[_stoves[s]].Step();
+                }
+            }
+            for (set<int>::iterator it = _inState[PREPPING].begin(); it != _inState[PREPPING].end(); ++it)
+            {
+                _tasks[*it].Step();
+            }
+            // What happened during this "second"
+            for (; more && r.GetKind() != TR_END && r.GetTime() == time; more = _trace.Next(r))
+            {
+                Apply(r, remarks);
+            }
+            rows.Row(time, columns + remarks);
+            time++;
+        }
+        rows.Flush();
+        if (!more)
+        {
+            fatal_err("Trace file is truncated.", 5);
+        }
+        // Last line, all stoves get cleaned
+        out << r.GetTime() << ", ";
+        string remarks;
+        for (int s = 0; s < _stoves.size(); s++)
+        {
+            out << "-- Idle --, ";
+            remarks += (s == 0) ? "" : " ";
+            remarks += "Cleaning " + Lower(stove_name(s, _stoves.size())) + ".";
+        }
+        out << ", , " << remarks << endl;
+    }
+private:
+    void Apply(const TraceRecord &r, string &remarks) // update the picture with one record
+    {
+        int i = r.GetDish();
+        switch (r.GetKind())
+        {
+        case TR_ARRIVE:
+            remarks += _trace.GetName(i) + " arrives. ";
+            _tasks.at(i) = Task(r.GetA(), r.GetB());
+            break;
+        case TR_TASK:
+            _tasks.at(i) = Task(r.GetA(), r.GetB());
+            break;
+        case TR_STATE:
+            SetState(i, (dish_state)r.GetA());
+            if (r.GetA() == DONE)
+            {
+                remarks += _trace.GetName(i) + " is Done. ";
+            }
+            break;
+        case TR_STOVE:
+            _stoves.at(r.GetA()) = i;
+            break;
+        case TR_CLEAN:
+            remarks += "Cleaning " + Lower(stove_name(r.GetA(), _stoves.size())) + ". ";
+            break;
+        case TR_PREHEAT:
+            remarks += "Preheating " + Lower(stove_name(r.GetA(), _stoves.size())) + ". ";
+            break;
+        case TR_BOOST:
+            remarks += "Priority boost. ";
+            break;
+        default:
+            // Preemption and queue levels do not show in the schedule
+            break;
+        }
+    }
+    void SetState(int i, dish_state s)
+    {
+        dish_state old = _states.at(i);
+        if (old == READY || old == PREPPING)
+        {
+            _inState[old].erase(i);
+        }
+        else if (old == PREPWAIT)
+        {
+            _prepLine.erase(find(_prepLine.begin(), _prepLine.end(), i));
+        }
+        if (s == READY || s == PREPPING)
+        {
+            _inState[s].insert(i);
+        }
+        else if (s == PREPWAIT)
+        {
+            _prepLine.push_back(i);
+        }
+        _states[i] = s;
+    }
+    string Show(int i) // dish i as shown in the schedule
+    {
+        ostringstream out;
+        out << _trace.GetName(i) << "(";
+        if (_states[i] == DONE)
+        {
+            out << "Done";
+        }
+        else
+        {
+            out << _tasks[i].GetStringType() << " - " << _tasks[i].GetTime();
+        }
+        out << ")";
+        return out.str();
+    }
+    string Columns() // the Stove, Ready and Assistants columns
+    {
+        string out;
+        for (int s = 0; s < _stoves.size(); s++)
+        {
+            out += (_stoves[s] > -1) ? Show(_stoves[s]) : "-- Idle --";
+            out += ", ";
+        }
+        for (set<int>::iterator it = _inState[READY].begin(); it != _inState[READY].end(); ++it)
+        {
+            if (find(_stoves.begin(), _stoves.end(), *it) == _stoves.end())
+            {
+                out += Show(*it) + "   ";
+            }
+        }
+        out += ", ";
+        for (set<int>::iterator it = _inState[PREPPING].begin(); it != _inState[PREPPING].end(); ++it)
+        {
+            out += Show(*it) + "   ";
+        }
+        for (deque<int>::iterator it = _prepLine.begin(); it != _prepLine.end(); ++it)
+        {
+            out += "[" + Show(*it) + "]   ";
+        }
+        out += ", ";
+        return out;
+    }
+    string Lower(string s) // lowercase copy of s
+    {
+        transform(s.begin(), s.end(), s.begin(), ::tolower);
+        return s;
+    }
+    TraceReader &_trace;
+    vector<Task> _tasks; // Task in progress per dish, with time remaining
+    vector<dish_state> _states; // State per dish
+    vector<int> _stoves; // Dish on each stove (-1 if none)
+    set<int> _inState[PREPPING + 1]; // READY and PREPPING dishes, in tasklist order
+    deque<int> _prepLine; // Dishes waiting for an assistant
+};
+
+int main(int argc, char *argv[])
+{
+    string traceFile;
+    string outputFile = "output.csv";
+    bool collapse = false;
+    int files = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--collapse")
+        {
+            collapse = true;
+        }
+        else if (files == 0)
+        {
+            traceFile = arg;
+            files++;
+        }
+        else if (files == 1)
+        {
+            outputFile = arg;
+            files++;
+        }
+        else
+        {
+            fatal_err("Usage: trace2csv TRACE [OUTPUT] [--collapse]", 7);
+        }
+    }
+    if (files == 0)
+    {
+        fatal_err("Usage: trace2csv TRACE [OUTPUT] [--collapse]", 7);
+    }
+
+    TraceReader trace(traceFile);
+    if (!trace.IsGood())
+    {
+        fatal_err("Trace file could not be read.", 1);
+    }
+    ofstream out(outputFile.c_str(), ofstream::out);
+    if (!out.is_open())
+    {
+        fatal_err("Output file could not be opened.", 6);
+    }
+    Replay replay(trace);
+    replay.Run(out, collapse);
+    out.close();
+    return 0;
+}
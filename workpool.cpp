@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <functional>
+
+using namespace std;
+
+/*
+ * WorkPool - runs numbered jobs on a fixed set of threads.
+ *
+ * Jobs are dealt round robin into one deque per worker. A worker takes
+ * jobs from the back of its own deque and, once that is empty, steals
+ * from the front of the others', so a few long jobs do not leave the
+ * remaining threads idle.
+ */
+class WorkPool
+{
+public:
+    WorkPool(int threads)
+    {
+        _threads = (threads > 0) ? threads : 1;
+    }
+    int GetThreads() // getter for number of worker threads
+    {
+        return _threads;
+    }
+    void Run(int jobs, const function<void(int)> &job) // run job(0) .. job(jobs - 1), return when all are done
+    {
+        int workers = (jobs < _threads) ? jobs : _threads;
+        if (workers <= 1)
+        {
+            for (int j = 0; j < jobs; j++)
+            {
+                job(j);
+            }
+            return;
+        }
+        vector<deque<int> > queues(workers);
+        vector<mutex> locks(workers);
+        for (int j = 0; j < jobs; j++)
+        {
+            queues[j % workers].push_back(j);
+        }
+        vector<thread> pool;
+        for (int w = 0; w < workers; w++)
+        {
+            pool.push_back(thread(Work, w, ref(queues), ref(locks), cref(job)));
+        }
+        for (int w = 0; w < workers; w++)
+        {
+            pool[w].join();
+        }
+    }
+private:
+    static void Work(int self, vector<deque<int> > &queues, vector<mutex> &locks, const function<void(int)> &job)
+    {
+        int workers = queues.size();
+        while (true)
+        {
+            int j = -1;
+            // Own jobs first, newest first
+            {
+                lock_guard<mutex> guard(locks[self]);
+                if (!queues[self].empty())
+                {
+                    j = queues[self].back();
+                    queues[self].pop_back();
+                }
+            }
+            // Steal the oldest job of another worker
+            for (int v = 1; v < workers && j == -1; v++)
+            {
+                int other = (self + v) % workers;
+                lock_guard<mutex> guard(locks[other]);
+                if (!queues[other].empty())
+                {
+                    j = queues[other].front();
+                    queues[other].pop_front();
+                }
+            }
+            if (j == -1)
+            {
+                return; // Nothing left anywhere; jobs never spawn jobs
+            }
+            job(j);
+        }
+    }
+    int _threads;
+};